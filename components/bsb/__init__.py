@@ -1,18 +1,35 @@
+import logging
 import re
+import zlib
+from collections import namedtuple
 import esphome.codegen as cg
 import esphome.config_validation as cv
-from esphome.components import uart
+import esphome.final_validate as fv
+from esphome.components import binary_sensor, sensor, uart
 from esphome.const import (
+    DEVICE_CLASS_CONNECTIVITY,
+    ENTITY_CATEGORY_DIAGNOSTIC,
+    STATE_CLASS_MEASUREMENT,
+    STATE_CLASS_TOTAL_INCREASING,
+    UNIT_MILLISECOND,
+    UNIT_BYTES,
+    UNIT_PERCENT,
     CONF_ID,
-    CONF_TRIGGER_ID
+    CONF_PLATFORM,
+    CONF_TIMEOUT,
+    CONF_TRIGGER_ID,
+    CONF_UPDATE_INTERVAL
 )
+from esphome.core import CORE, ID, TimePeriod
 from esphome import automation
 
+_LOGGER = logging.getLogger(__name__)
+
 CODEOWNERS = ["@eringerli"]
 MULTI_CONF = True
 
 DEPENDENCIES = ["uart"]
-AUTO_LOAD = ["sensor", "text_sensor"] #, "switch", "binary_sensor"
+AUTO_LOAD = ["sensor", "text_sensor", "binary_sensor"] #, "switch"
 CONF_BSB_ID = "bsb_id"
 CONF_PARAMETER_NUMBER = "parameter_number"
 CONF_SOURCE_ADDRESS = "source_address"
@@ -21,20 +38,80 @@ CONF_QUERY_INTERVAL = "query_interval"
 CONF_RETRY_INTERVAL = "retry_interval"
 CONF_RETRY_COUNT = "retry_count"
 CONF_BSB_TYPE= "type"
+CONF_SNAPSHOT_INTERVAL = "snapshot_interval"
+CONF_PASSIVE = "passive"
+CONF_MAX_BUS_UTILIZATION = "max_bus_utilization"
+CONF_BUS_OVERLOAD = "bus_overload"
+CONF_LINK_STATE = "link_state"
+CONF_PROBE_FIELD_ID = "probe_field_id"
+CONF_LOOP_TIME = "loop_time"
+CONF_ALLOCATION_AUDIT = "allocation_audit"
+CONF_ALLOCATIONS = "allocations"
+CONF_BYTES = "bytes"
+CONF_HIGH_WATER_MARK = "high_water_mark"
+CONF_BROADCAST = "broadcast"
+CONF_BROADCAST_INTERVAL = "broadcast_interval"
+CONF_ON_SNAPSHOT = "on_snapshot"
+CONF_ON_CAPTURE = "on_capture"
+CONF_GROUPS = "groups"
+CONF_GROUP = "group"
+CONF_FIELD_ID = "field_id"
+CONF_UART_ID = "uart_id"
+CONF_RESTORE = "restore"
+CONF_REFRESH_LATENCY = "refresh_latency"
+CONF_IDLE_MULTIPLIER = "idle_multiplier"
+CONF_SLOT_ALIGNMENT = "slot_alignment"
+CONF_COLLISION_RATE = "collision_rate"
+CONF_MASK = "mask"
+CONF_PRIORITY = "priority"
+CONF_LOAD_SHEDDING = "load_shedding"
+CONF_SHEDDING_LEVEL = "shedding_level"
+CONF_SHIFT = "shift"
+CONF_MULTI_BUS = "multi_bus"
+
+bsb_ns = cg.esphome_ns.namespace("bsb")
+
+# the value types map to the codec traits in bsbCodec.h, which are used as template arguments of the entities
+CONF_BSB_INTEGER_TYPE_ENUM = {
+    "UINT8": bsb_ns.struct("BsbCodecUInt8"),
+    "INT8": bsb_ns.struct("BsbCodecInt8"),
+    "UINT16": bsb_ns.struct("BsbCodecUInt16"),
+    "INT16": bsb_ns.struct("BsbCodecInt16"),
+    "UINT32": bsb_ns.struct("BsbCodecUInt32"),
+    "INT32": bsb_ns.struct("BsbCodecInt32"),
+}
 
 CONF_BSB_TYPE_ENUM = {
-    "UINT8":0,
-    "INT8":1,
-    "INT16":2,
-    "INT32":3,
-    "TEMPERATURE":4,
-    "ROOMTEMPERATURE":5
+    **CONF_BSB_INTEGER_TYPE_ENUM,
+    "TEMPERATURE": bsb_ns.struct("BsbCodecTemperature"),
+    "ROOMTEMPERATURE": bsb_ns.struct("BsbCodecRoomTemperature"),
+    "PERCENT_HALF": bsb_ns.struct("BsbCodecPercentHalf"),
+    "WEEKDAY": bsb_ns.struct("BsbCodecWeekday"),
 }
 
-bsb_ns = cg.esphome_ns.namespace("bsb")
+CONF_BSB_ENUM_TYPE_ENUM = {
+    "ENUM": bsb_ns.struct("BsbCodecEnum"),
+    "ENUM16": bsb_ns.struct("BsbCodecEnum16"),
+}
+
+# under load, the background entities are stretched first and the critical ones never, see bsbGovernor.h
+BsbPriority = bsb_ns.enum("BsbPriority", is_class=True)
+PRIORITIES = {
+    "CRITICAL": BsbPriority.Critical,
+    "NORMAL": BsbPriority.Normal,
+    "BACKGROUND": BsbPriority.Background,
+}
+
+CONF_BSB_TEXT_TYPE_ENUM = {
+    "TEXT": bsb_ns.struct("BsbCodecText"),
+    "DATETIME": bsb_ns.struct("BsbCodecDateTime"),
+    "WEEKDAY": bsb_ns.struct("BsbCodecWeekday"),
+}
 BsbComponent = bsb_ns.class_(
     "BsbComponent", cg.Component, uart.UARTDevice
 )
+# serves all buses in multi-bus mode, see bsbEngine.h
+BsbEngine = bsb_ns.class_("BsbEngine", cg.Component)
 
 BsbTimeoutTrigger = bsb_ns.class_(
     "BsbTimeoutTrigger", automation.Trigger
@@ -42,6 +119,243 @@ BsbTimeoutTrigger = bsb_ns.class_(
 BsbWaitNextReadoutTrigger = bsb_ns.class_(
     "BsbWaitNextReadoutTrigger", automation.Trigger
 )
+BsbSnapshotTrigger = bsb_ns.class_(
+    "BsbSnapshotTrigger", automation.Trigger.template(cg.std_vector.template(cg.uint8))
+)
+
+BsbCaptureTrigger = bsb_ns.class_(
+    "BsbCaptureTrigger", automation.Trigger.template(cg.std_vector.template(cg.uint8))
+)
+
+BsbSnapshotAction = bsb_ns.class_("BsbSnapshotAction", automation.Action)
+BsbRefreshAction = bsb_ns.class_("BsbRefreshAction", automation.Action)
+BsbSetQueryIntervalAction = bsb_ns.class_("BsbSetQueryIntervalAction", automation.Action)
+BsbSetUpdateIntervalAction = bsb_ns.class_("BsbSetUpdateIntervalAction", automation.Action)
+BsbPauseFieldAction = bsb_ns.class_("BsbPauseFieldAction", automation.Action)
+BsbResumeFieldAction = bsb_ns.class_("BsbResumeFieldAction", automation.Action)
+
+BsbGroup = bsb_ns.class_("BsbGroup")
+
+# bus budget: 4800 baud with 8 data bits, parity and a stop bit
+BUS_SECONDS_PER_BYTE = 11 / 4800
+# typical time the heating system needs to answer a Get
+BUS_REPLY_LATENCY = 0.1
+BUS_FRAME_SIZE_WITHOUT_PAYLOAD = 11
+BUS_PAYLOAD_LENGTH = {
+    "UINT8": 2,
+    "INT8": 2,
+    "UINT16": 3,
+    "INT16": 3,
+    "UINT32": 5,
+    "INT32": 5,
+    "TEMPERATURE": 3,
+    "ROOMTEMPERATURE": 3,
+    "PERCENT_HALF": 2,
+    "WEEKDAY": 2,
+    "DATETIME": 9,
+    "ENUM": 2,
+    "ENUM16": 3,
+    "TEXT": 32,
+}
+BUS_PLATFORMS = ["sensor", "binary_sensor", "text_sensor", "number", "switch", "select"]
+BUS_OVERLOAD_OPTIONS = ["WARN", "FAIL", "SCALE"]
+
+CONF_ENUM_TABLE_ID = "enum_table_id"
+BsbEnumEntry = bsb_ns.struct("BsbEnumEntry")
+
+
+def enum_options(value):
+    """Validates a mapping of the values on the bus to their labels."""
+    if not isinstance(value, dict) or not value:
+        raise cv.Invalid("Expected a mapping of values to labels, pe '0: Off'")
+
+    options = {}
+    for raw, label in value.items():
+        options[cv.uint32_t(raw)] = cv.string_strict(label)
+
+    if len(set(options.values())) != len(options):
+        raise cv.Invalid("The labels of an enumeration have to be unique")
+    return options
+
+
+async def enum_table(var, config, options):
+    """Generates the table of an enumeration as const array, sorted by value for the binary search."""
+    entries = [cg.ArrayInitializer(raw, label) for raw, label in sorted(options.items())]
+    table = cg.static_const_array(config[CONF_ENUM_TABLE_ID], cg.ArrayInitializer(*entries, multiline=True))
+    cg.add(var.set_enum_table(table, len(entries)))
+
+
+BusBudget = namedtuple("BusBudget", ["transactions", "utilization", "broadcast_utilization"])
+
+
+def interval_seconds(value):
+    # "never" is validated to the maximum of an uint32
+    if not isinstance(value, TimePeriod) or value.total_milliseconds == 0:
+        return None
+    return value.total_milliseconds / 1000
+
+
+def bus_query_interval(bsb_id):
+    """The query interval of the bus in ms, no two Gets of the bus are closer to each other."""
+    for conf in CORE.config.get("bsb", []):
+        if conf[CONF_ID].id == bsb_id.id:
+            return conf[CONF_QUERY_INTERVAL].total_milliseconds
+    return None
+
+
+async def register_group_member(var, config):
+    if CONF_GROUP in config:
+        group = await cg.get_variable(config[CONF_GROUP])
+        cg.add(group.add_member(var))
+
+
+# a slice of an integer value, see BsbBitfield in bsbCodec.h
+BITFIELD_SCHEMA = cv.Schema(
+    {
+        cv.Optional(CONF_MASK): cv.All(cv.hex_uint32_t, cv.Range(min=1)),
+        cv.Optional(CONF_SHIFT): cv.int_range(0, 31),
+    }
+)
+
+
+def validate_bitfield(types):
+    def validator(config):
+        if CONF_MASK not in config and CONF_SHIFT not in config:
+            return config
+        if str(config[CONF_BSB_TYPE]).upper() not in types:
+            raise cv.Invalid(f"{CONF_MASK} and {CONF_SHIFT} need one of the types {', '.join(types)}")
+        return config
+
+    return validator
+
+
+async def set_bitfield(var, config):
+    if CONF_MASK in config or CONF_SHIFT in config:
+        mask = config.get(CONF_MASK, 0xFFFFFFFF)
+        # without shift, the slice is shifted down to bit 0, so a single bit gives 0 or 1
+        shift = config.get(CONF_SHIFT, (mask & -mask).bit_length() - 1)
+        cg.add(var.set_bitfield(mask, shift))
+
+
+PRIORITY_SCHEMA = cv.Schema(
+    {
+        cv.Optional(CONF_PRIORITY, default="NORMAL"): cv.enum(PRIORITIES, upper=True),
+    }
+)
+
+
+async def set_priority(var, config):
+    if config[CONF_PRIORITY] != "NORMAL":
+        cg.add(var.set_priority(config[CONF_PRIORITY]))
+
+
+def bus_entities(config, full_config):
+    """Yields the configurations of all entities of this bus."""
+    for domain in BUS_PLATFORMS:
+        for conf in full_config.get(domain, []):
+            if conf.get(CONF_PLATFORM) == "bsb" and conf[CONF_BSB_ID].id == config[CONF_ID].id:
+                yield conf
+
+
+def bus_budget(config, full_config):
+    """Sums up the transactions per second and the share of the bus time used by all entities of this bus."""
+    query_interval = config[CONF_QUERY_INTERVAL].total_milliseconds / 1000
+    groups = {conf[CONF_ID].id: conf[CONF_UPDATE_INTERVAL] for conf in config.get(CONF_GROUPS, [])}
+    transactions = 0
+    utilization = 0
+    broadcast_utilization = 0
+    polls = {}
+
+    for conf in bus_entities(config, full_config):
+        frame = BUS_FRAME_SIZE_WITHOUT_PAYLOAD + BUS_PAYLOAD_LENGTH.get(str(conf.get(CONF_BSB_TYPE, "")).upper(), 2)
+
+        if conf.get(CONF_BROADCAST, False):
+            interval = interval_seconds(conf.get(CONF_BROADCAST_INTERVAL))
+            if interval is not None:
+                cost = max(query_interval, frame * BUS_SECONDS_PER_BYTE)
+                transactions += 1 / interval
+                broadcast_utilization += cost / interval
+            continue
+
+        # the members of a group are polled at the interval of the group
+        interval = interval_seconds(groups.get(conf[CONF_GROUP].id) if CONF_GROUP in conf else conf.get(CONF_UPDATE_INTERVAL))
+        if interval is not None:
+            # entities with the same field ID share the Get with the shortest interval
+            key = (conf[CONF_FIELD_ID], conf[CONF_GROUP].id if CONF_GROUP in conf else None)
+            if key not in polls or interval < polls[key][0]:
+                polls[key] = (interval, frame)
+
+    for interval, frame in polls.values():
+        # Get and Ret, every transaction takes at least one query interval
+        cost = max(query_interval, (BUS_FRAME_SIZE_WITHOUT_PAYLOAD + frame) * BUS_SECONDS_PER_BYTE + BUS_REPLY_LATENCY)
+        transactions += 1 / interval
+        utilization += cost / interval
+
+    return BusBudget(transactions, utilization + broadcast_utilization, broadcast_utilization)
+
+
+def validate_bus_budget(config):
+    if config[CONF_PASSIVE]:
+        return config
+
+    budget = bus_budget(config, fv.full_config.get())
+    limit = config[CONF_MAX_BUS_UTILIZATION]
+
+    if budget.utilization > limit:
+        message = (
+            f"BSB bus {config[CONF_ID].id}: the entities need {budget.transactions:.2f} transactions/s, "
+            f"that is {budget.utilization * 100:.0f}% of the bus (maximum {limit * 100:.0f}%). "
+            "Increase the update_interval of some entities."
+        )
+        if config[CONF_BUS_OVERLOAD] == "FAIL":
+            raise cv.Invalid(message)
+        if config[CONF_BUS_OVERLOAD] == "SCALE" and budget.broadcast_utilization >= limit:
+            raise cv.Invalid(message + " The broadcasts alone exceed the budget, so the intervals can't be scaled.")
+        if config[CONF_BUS_OVERLOAD] == "WARN":
+            _LOGGER.warning(message)
+
+    return config
+
+
+def validate_groups(config):
+    groups = [conf[CONF_ID].id for conf in config.get(CONF_GROUPS, [])]
+
+    for conf in bus_entities(config, fv.full_config.get()):
+        if CONF_GROUP in conf and conf[CONF_GROUP].id not in groups:
+            raise cv.Invalid(f"The group {conf[CONF_GROUP].id} has to be defined on the same bus {config[CONF_ID].id} as its members")
+
+    return config
+
+
+def validate_uart(config):
+    # every bus needs its own UART, the receivers of two components would steal each other's bytes
+    buses = [conf for conf in fv.full_config.get().get("bsb", []) if conf[CONF_UART_ID] == config[CONF_UART_ID]]
+    if len(buses) > 1:
+        raise cv.Invalid(f"The BSB buses {', '.join(str(conf[CONF_ID].id) for conf in buses)} use the same UART {config[CONF_UART_ID].id}")
+
+    return config
+
+
+def validate_idle_multiplier(config):
+    # without API or MQTT, there is never a consumer and the polls would always be slowed down
+    full_config = fv.full_config.get()
+    if CONF_IDLE_MULTIPLIER in config and "api" not in full_config and "mqtt" not in full_config:
+        raise cv.Invalid(f"{CONF_IDLE_MULTIPLIER} needs the api or mqtt component to detect the consumers")
+
+    return config
+
+
+def validate_multi_bus(config):
+    # one engine serves all buses or none
+    buses = fv.full_config.get().get("bsb", [])
+    if any(conf[CONF_MULTI_BUS] != config[CONF_MULTI_BUS] for conf in buses):
+        raise cv.Invalid(f"{CONF_MULTI_BUS} has to be set on all BSB buses or on none")
+
+    return config
+
+
+FINAL_VALIDATE_SCHEMA = cv.All(validate_uart, validate_groups, validate_bus_budget, validate_idle_multiplier, validate_multi_bus)
+
 
 def validate_baud_rate(value):
     if value > 0:
@@ -65,6 +379,83 @@ CONFIG_SCHEMA = cv.All(
             cv.Optional(
                 CONF_DESTINATION_ADDRESS, default="0"
             ): cv.positive_int,
+            cv.Optional(CONF_PASSIVE, default=False): cv.boolean,
+            cv.Optional(CONF_MULTI_BUS, default=False): cv.boolean,
+            cv.Optional(CONF_RESTORE, default=False): cv.boolean,
+            cv.Optional(CONF_IDLE_MULTIPLIER): cv.float_range(min=1),
+            cv.Optional(CONF_SLOT_ALIGNMENT, default=False): cv.boolean,
+            cv.Optional(CONF_LOAD_SHEDDING, default=False): cv.boolean,
+            cv.Optional(CONF_MAX_BUS_UTILIZATION, default="80%"): cv.percentage,
+            cv.Optional(CONF_BUS_OVERLOAD, default="WARN"): cv.one_of(*BUS_OVERLOAD_OPTIONS, upper=True),
+            cv.Optional(CONF_PROBE_FIELD_ID): cv.All(cv.hex_uint32_t, cv.Range(min=1)),
+            cv.Optional(CONF_LINK_STATE): binary_sensor.binary_sensor_schema(
+                device_class=DEVICE_CLASS_CONNECTIVITY,
+                entity_category=ENTITY_CATEGORY_DIAGNOSTIC,
+            ),
+            cv.Optional(CONF_REFRESH_LATENCY): sensor.sensor_schema(
+                unit_of_measurement=UNIT_MILLISECOND,
+                accuracy_decimals=0,
+                state_class=STATE_CLASS_MEASUREMENT,
+                entity_category=ENTITY_CATEGORY_DIAGNOSTIC,
+            ),
+            cv.Optional(CONF_COLLISION_RATE): sensor.sensor_schema(
+                unit_of_measurement=UNIT_PERCENT,
+                accuracy_decimals=1,
+                state_class=STATE_CLASS_MEASUREMENT,
+                entity_category=ENTITY_CATEGORY_DIAGNOSTIC,
+            ),
+            cv.Optional(CONF_SHEDDING_LEVEL): sensor.sensor_schema(
+                accuracy_decimals=0,
+                state_class=STATE_CLASS_MEASUREMENT,
+                entity_category=ENTITY_CATEGORY_DIAGNOSTIC,
+            ),
+            cv.Optional(CONF_LOOP_TIME): sensor.sensor_schema(
+                unit_of_measurement="ms/s",
+                accuracy_decimals=2,
+                state_class=STATE_CLASS_MEASUREMENT,
+                entity_category=ENTITY_CATEGORY_DIAGNOSTIC,
+            ),
+            cv.Optional(CONF_ALLOCATION_AUDIT): cv.Schema(
+                {
+                    cv.Optional(CONF_ALLOCATIONS): sensor.sensor_schema(
+                        accuracy_decimals=0,
+                        state_class=STATE_CLASS_TOTAL_INCREASING,
+                        entity_category=ENTITY_CATEGORY_DIAGNOSTIC,
+                    ),
+                    cv.Optional(CONF_BYTES): sensor.sensor_schema(
+                        unit_of_measurement=UNIT_BYTES,
+                        accuracy_decimals=0,
+                        state_class=STATE_CLASS_TOTAL_INCREASING,
+                        entity_category=ENTITY_CATEGORY_DIAGNOSTIC,
+                    ),
+                    cv.Optional(CONF_HIGH_WATER_MARK): sensor.sensor_schema(
+                        unit_of_measurement=UNIT_BYTES,
+                        accuracy_decimals=0,
+                        state_class=STATE_CLASS_MEASUREMENT,
+                        entity_category=ENTITY_CATEGORY_DIAGNOSTIC,
+                    ),
+                }
+            ),
+            cv.Optional(CONF_GROUPS): cv.ensure_list(
+                cv.Schema(
+                    {
+                        cv.Required(CONF_ID): cv.declare_id(BsbGroup),
+                        cv.Optional(CONF_UPDATE_INTERVAL, default="1min"): cv.positive_time_period_milliseconds,
+                        cv.Optional(CONF_TIMEOUT, default="5s"): cv.positive_time_period_milliseconds,
+                    }
+                ).extend(PRIORITY_SCHEMA)
+            ),
+            cv.Optional(CONF_SNAPSHOT_INTERVAL): cv.positive_time_period_milliseconds,
+            cv.Optional(CONF_ON_SNAPSHOT): automation.validate_automation(
+                {
+                    cv.GenerateID(CONF_TRIGGER_ID): cv.declare_id(BsbSnapshotTrigger),
+                }
+            ),
+            cv.Optional(CONF_ON_CAPTURE): automation.validate_automation(
+                {
+                    cv.GenerateID(CONF_TRIGGER_ID): cv.declare_id(BsbCaptureTrigger),
+                }
+            ),
         }
     )
     .extend(cv.COMPONENT_SCHEMA)
@@ -72,6 +463,16 @@ CONFIG_SCHEMA = cv.All(
 )
 
 
+async def multi_bus_engine():
+    # created with the first bus, the others are registered with the same one
+    data = CORE.data.setdefault("bsb", {})
+    if "engine" not in data:
+        engine = cg.new_Pvariable(ID("bsb_engine", is_declaration=True, type=BsbEngine))
+        await cg.register_component(engine, {})
+        data["engine"] = engine
+    return data["engine"]
+
+
 async def to_code(config):
     var = cg.new_Pvariable(config[CONF_ID])
     await cg.register_component(var, config)
@@ -91,3 +492,189 @@ async def to_code(config):
 
     if CONF_DESTINATION_ADDRESS in config:
         cg.add(var.set_destination_address(config[CONF_DESTINATION_ADDRESS]))
+
+    if CONF_PASSIVE in config:
+        cg.add(var.set_passive(config[CONF_PASSIVE]))
+
+    if config[CONF_MULTI_BUS]:
+        engine = await multi_bus_engine()
+        cg.add(engine.register_bus(var))
+
+    if CONF_IDLE_MULTIPLIER in config:
+        cg.add(var.set_idle_multiplier(config[CONF_IDLE_MULTIPLIER]))
+
+    if config[CONF_SLOT_ALIGNMENT]:
+        cg.add(var.set_slot_alignment(True))
+
+    if config[CONF_LOAD_SHEDDING]:
+        cg.add(var.set_load_shedding(config[CONF_MAX_BUS_UTILIZATION]))
+
+    if config[CONF_RESTORE]:
+        # the preferences of every bus get their own keys
+        cg.add(var.set_restore(zlib.crc32(f"bsb_{config[CONF_ID].id}".encode())))
+
+    if not config[CONF_PASSIVE]:
+        budget = bus_budget(config, CORE.config)
+        cg.add(var.set_bus_budget(budget.transactions, budget.utilization))
+
+        limit = config[CONF_MAX_BUS_UTILIZATION]
+        if config[CONF_BUS_OVERLOAD] == "SCALE" and budget.utilization > limit:
+            # stretch the polls, so they fit into what the broadcasts leave over
+            polled = budget.utilization - budget.broadcast_utilization
+            scale = polled / (limit - budget.broadcast_utilization)
+            _LOGGER.info("BSB bus %s: scaling the update intervals by %.2f to fit the bus budget", config[CONF_ID].id, scale)
+            cg.add(var.set_interval_scale(scale))
+
+    if CONF_PROBE_FIELD_ID in config:
+        cg.add(var.set_probe_field_id(config[CONF_PROBE_FIELD_ID]))
+
+    if CONF_LINK_STATE in config:
+        sens = await binary_sensor.new_binary_sensor(config[CONF_LINK_STATE])
+        cg.add(var.set_link_sensor(sens))
+
+    for conf in config.get(CONF_GROUPS, []):
+        group = cg.new_Pvariable(conf[CONF_ID])
+        cg.add(group.set_update_interval(conf[CONF_UPDATE_INTERVAL]))
+        cg.add(group.set_timeout(conf[CONF_TIMEOUT]))
+        await set_priority(group, conf)
+        cg.add(var.register_group(group))
+
+    if CONF_ALLOCATION_AUDIT in config:
+        # replaces the global operator new with a counting one, so only meant for debugging
+        cg.add_define("USE_BSB_ALLOCATION_AUDIT")
+        audit = config[CONF_ALLOCATION_AUDIT]
+
+        if CONF_ALLOCATIONS in audit:
+            sens = await sensor.new_sensor(audit[CONF_ALLOCATIONS])
+            cg.add(var.set_allocations_sensor(sens))
+
+        if CONF_BYTES in audit:
+            sens = await sensor.new_sensor(audit[CONF_BYTES])
+            cg.add(var.set_allocated_bytes_sensor(sens))
+
+        if CONF_HIGH_WATER_MARK in audit:
+            sens = await sensor.new_sensor(audit[CONF_HIGH_WATER_MARK])
+            cg.add(var.set_allocation_high_water_sensor(sens))
+
+    if CONF_REFRESH_LATENCY in config:
+        sens = await sensor.new_sensor(config[CONF_REFRESH_LATENCY])
+        cg.add(var.set_refresh_latency_sensor(sens))
+
+    if CONF_COLLISION_RATE in config:
+        sens = await sensor.new_sensor(config[CONF_COLLISION_RATE])
+        cg.add(var.set_collision_rate_sensor(sens))
+
+    if CONF_SHEDDING_LEVEL in config:
+        sens = await sensor.new_sensor(config[CONF_SHEDDING_LEVEL])
+        cg.add(var.set_shedding_level_sensor(sens))
+
+    if CONF_LOOP_TIME in config:
+        sens = await sensor.new_sensor(config[CONF_LOOP_TIME])
+        cg.add(var.set_loop_time_sensor(sens))
+
+    if CONF_SNAPSHOT_INTERVAL in config:
+        cg.add(var.set_snapshot_interval(config[CONF_SNAPSHOT_INTERVAL]))
+
+    for conf in config.get(CONF_ON_SNAPSHOT, []):
+        trigger = cg.new_Pvariable(conf[CONF_TRIGGER_ID], var)
+        await automation.build_automation(trigger, [(cg.std_vector.template(cg.uint8), "x")], conf)
+
+    for conf in config.get(CONF_ON_CAPTURE, []):
+        trigger = cg.new_Pvariable(conf[CONF_TRIGGER_ID], var)
+        await automation.build_automation(trigger, [(cg.std_vector.template(cg.uint8), "x")], conf)
+
+
+@automation.register_action(
+    "bsb.snapshot",
+    BsbSnapshotAction,
+    cv.Schema(
+        {
+            cv.GenerateID(): cv.use_id(BsbComponent),
+        }
+    ),
+)
+async def bsb_snapshot_to_code(config, action_id, template_arg, args):
+    var = cg.new_Pvariable(action_id, template_arg)
+    await cg.register_parented(var, config[CONF_ID])
+    return var
+
+
+FIELD_ACTION_SCHEMA = cv.Schema(
+    {
+        cv.GenerateID(): cv.use_id(BsbComponent),
+        cv.Required(CONF_FIELD_ID): cv.templatable(cv.positive_int),
+    }
+)
+
+
+@automation.register_action(
+    "bsb.refresh",
+    BsbRefreshAction,
+    cv.All(
+        cv.Schema(
+            {
+                cv.GenerateID(): cv.use_id(BsbComponent),
+                cv.Optional(CONF_FIELD_ID): cv.templatable(cv.positive_int),
+                cv.Optional(CONF_GROUP): cv.use_id(BsbGroup),
+            }
+        ),
+        cv.has_exactly_one_key(CONF_FIELD_ID, CONF_GROUP),
+    ),
+)
+async def bsb_refresh_to_code(config, action_id, template_arg, args):
+    var = cg.new_Pvariable(action_id, template_arg)
+    await cg.register_parented(var, config[CONF_ID])
+    if CONF_GROUP in config:
+        group = await cg.get_variable(config[CONF_GROUP])
+        cg.add(var.set_group(group))
+    else:
+        template_ = await cg.templatable(config[CONF_FIELD_ID], args, cg.uint32)
+        cg.add(var.set_field_id(template_))
+    return var
+
+
+@automation.register_action(
+    "bsb.set_query_interval",
+    BsbSetQueryIntervalAction,
+    cv.Schema(
+        {
+            cv.GenerateID(): cv.use_id(BsbComponent),
+            cv.Required(CONF_QUERY_INTERVAL): cv.templatable(cv.positive_time_period_milliseconds),
+        }
+    ),
+)
+async def bsb_set_query_interval_to_code(config, action_id, template_arg, args):
+    var = cg.new_Pvariable(action_id, template_arg)
+    await cg.register_parented(var, config[CONF_ID])
+    template_ = await cg.templatable(config[CONF_QUERY_INTERVAL], args, cg.uint32)
+    cg.add(var.set_query_interval(template_))
+    return var
+
+
+@automation.register_action(
+    "bsb.set_update_interval",
+    BsbSetUpdateIntervalAction,
+    FIELD_ACTION_SCHEMA.extend(
+        {
+            cv.Required(CONF_UPDATE_INTERVAL): cv.templatable(cv.positive_time_period_milliseconds),
+        }
+    ),
+)
+async def bsb_set_update_interval_to_code(config, action_id, template_arg, args):
+    var = cg.new_Pvariable(action_id, template_arg)
+    await cg.register_parented(var, config[CONF_ID])
+    template_ = await cg.templatable(config[CONF_FIELD_ID], args, cg.uint32)
+    cg.add(var.set_field_id(template_))
+    template_ = await cg.templatable(config[CONF_UPDATE_INTERVAL], args, cg.uint32)
+    cg.add(var.set_update_interval(template_))
+    return var
+
+
+@automation.register_action("bsb.pause_field", BsbPauseFieldAction, FIELD_ACTION_SCHEMA)
+@automation.register_action("bsb.resume_field", BsbResumeFieldAction, FIELD_ACTION_SCHEMA)
+async def bsb_field_to_code(config, action_id, template_arg, args):
+    var = cg.new_Pvariable(action_id, template_arg)
+    await cg.register_parented(var, config[CONF_ID])
+    template_ = await cg.templatable(config[CONF_FIELD_ID], args, cg.uint32)
+    cg.add(var.set_field_id(template_))
+    return var
@@ -0,0 +1,99 @@
+#pragma once
+
+#include "bsb.h"
+#include "esphome/core/automation.h"
+
+#include <cstdint>
+#include <vector>
+
+namespace esphome {
+  namespace bsb {
+
+    class BsbSnapshotTrigger : public Trigger< std::vector< uint8_t > > {
+    public:
+      explicit BsbSnapshotTrigger( BsbComponent* parent ) {
+        parent->add_on_snapshot_callback( [this]( const std::vector< uint8_t >& snapshot ) { this->trigger( snapshot ); } );
+      }
+    };
+
+    class BsbCaptureTrigger : public Trigger< std::vector< uint8_t > > {
+    public:
+      explicit BsbCaptureTrigger( BsbComponent* parent ) {
+        parent->add_on_capture_callback( [this]( const std::vector< uint8_t >& record ) { this->trigger( record ); } );
+      }
+    };
+
+    template< typename... Ts >
+    class BsbSnapshotAction
+        : public Action< Ts... >
+        , public Parented< BsbComponent > {
+    public:
+      void play( Ts... x ) override { this->parent_->publish_snapshot(); }
+    };
+
+    template< typename... Ts >
+    class BsbRefreshAction
+        : public Action< Ts... >
+        , public Parented< BsbComponent > {
+    public:
+      TEMPLATABLE_VALUE( uint32_t, field_id )
+
+      void set_group( BsbGroup* group ) { this->group_ = group; }
+
+      void play( Ts... x ) override {
+        if( this->group_ != nullptr ) {
+          this->parent_->request_group_refresh( this->group_ );
+        } else {
+          this->parent_->request_refresh( this->field_id_.value( x... ) );
+        }
+      }
+
+    protected:
+      BsbGroup* group_ = nullptr;
+    };
+
+    template< typename... Ts >
+    class BsbSetQueryIntervalAction
+        : public Action< Ts... >
+        , public Parented< BsbComponent > {
+    public:
+      TEMPLATABLE_VALUE( uint32_t, query_interval )
+
+      void play( Ts... x ) override { this->parent_->change_query_interval( this->query_interval_.value( x... ) ); }
+    };
+
+    template< typename... Ts >
+    class BsbSetUpdateIntervalAction
+        : public Action< Ts... >
+        , public Parented< BsbComponent > {
+    public:
+      TEMPLATABLE_VALUE( uint32_t, field_id )
+      TEMPLATABLE_VALUE( uint32_t, update_interval )
+
+      void play( Ts... x ) override {
+        this->parent_->set_field_update_interval( this->field_id_.value( x... ), this->update_interval_.value( x... ) );
+      }
+    };
+
+    template< typename... Ts >
+    class BsbPauseFieldAction
+        : public Action< Ts... >
+        , public Parented< BsbComponent > {
+    public:
+      TEMPLATABLE_VALUE( uint32_t, field_id )
+
+      void play( Ts... x ) override { this->parent_->set_field_paused( this->field_id_.value( x... ), true ); }
+    };
+
+    template< typename... Ts >
+    class BsbResumeFieldAction
+        : public Action< Ts... >
+        , public Parented< BsbComponent > {
+    public:
+      TEMPLATABLE_VALUE( uint32_t, field_id )
+
+      void play( Ts... x ) override { this->parent_->set_field_paused( this->field_id_.value( x... ), false ); }
+    };
+
+  } // namespace bsb
+} // namespace esphome
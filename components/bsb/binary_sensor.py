@@ -1,7 +1,21 @@
 import esphome.codegen as cg
 import esphome.config_validation as cv
 from esphome.components import binary_sensor
-from . import BsbComponent, bsb_ns, CONF_BSB_ID, CONF_PARAMETER_NUMBER, CONF_BSB_TYPE
+from . import (
+    BsbComponent,
+    BsbGroup,
+    bsb_ns,
+    register_group_member,
+    set_bitfield,
+    set_priority,
+    BITFIELD_SCHEMA,
+    PRIORITY_SCHEMA,
+    CONF_BSB_ID,
+    CONF_GROUP,
+    CONF_PARAMETER_NUMBER,
+    CONF_BSB_INTEGER_TYPE_ENUM,
+    CONF_BSB_TYPE
+)
 
 from esphome.const import (
     CONF_UPDATE_INTERVAL
@@ -12,41 +26,38 @@ CONF_ON_VALUE = "on_value"
 CONF_OFF_VALUE = "off_value"
 CONF_ENABLE_BYTE = "enable_byte"
 
-CONF_BSB_TYPE_ENUM = {
-    "UINT8":0,
-    "INT8":1,
-    "INT16":2,
-    "INT32":3
-}
-
 BsbBinarySensor = bsb_ns.class_("BsbBinarySensor", binary_sensor.BinarySensor)
+BsbBinarySensorTyped = bsb_ns.class_("BsbBinarySensorTyped", BsbBinarySensor)
 
 CONFIG_SCHEMA = cv.All(
     binary_sensor.binary_sensor_schema(
-        BsbBinarySensor,
+        BsbBinarySensorTyped,
     ).extend(
         {
             cv.GenerateID(CONF_BSB_ID): cv.use_id(BsbComponent),
             cv.Required(CONF_FIELD_ID): cv.positive_int,
             cv.Optional(CONF_ENABLE_BYTE, default="1"): cv.hex_int_range(0x00,0xff),
             cv.Optional(CONF_PARAMETER_NUMBER, default="0"): cv.positive_int,
-            cv.Optional(CONF_BSB_TYPE, default="INT8"): cv.enum(CONF_BSB_TYPE_ENUM, upper=True, space="_"),
+            cv.Optional(CONF_BSB_TYPE, default="INT8"): cv.enum(CONF_BSB_INTEGER_TYPE_ENUM, upper=True, space="_"),
             cv.Optional(CONF_UPDATE_INTERVAL, default="15min"): cv.update_interval,
+            cv.Optional(CONF_GROUP): cv.use_id(BsbGroup),
             cv.Optional(CONF_OFF_VALUE, default="0"): cv.positive_int,
             cv.Optional(CONF_ON_VALUE, default="1"): cv.positive_int,
         }
-    ),
+    ).extend(BITFIELD_SCHEMA, PRIORITY_SCHEMA),
     cv.has_exactly_one_key(CONF_FIELD_ID),
 )
 
 
 async def to_code(config):
     component = await cg.get_variable(config[CONF_BSB_ID])
-    var = await binary_sensor.new_binary_sensor(config)
+    var = await binary_sensor.new_binary_sensor(config, cg.TemplateArguments(config[CONF_BSB_TYPE]))
 
     if CONF_FIELD_ID in config:
         cg.add(var.set_field_id(config[CONF_FIELD_ID]))
 
+    await set_bitfield(var, config)
+
     if CONF_ON_VALUE in config:
         cg.add(var.set_on_value(config[CONF_ON_VALUE]))
 
@@ -56,12 +67,13 @@ async def to_code(config):
     if CONF_ENABLE_BYTE in config:
         cg.add(var.set_enable_byte(config[CONF_ENABLE_BYTE]))
 
-    if CONF_BSB_TYPE in config:
-        cg.add(var.set_value_type(config[CONF_BSB_TYPE]))
-
     if CONF_UPDATE_INTERVAL in config:
         cg.add(var.set_update_interval(config[CONF_UPDATE_INTERVAL]))
 
+    await set_priority(var, config)
+
+    await register_group_member(var, config)
+
     cg.add(component.register_sensor(var))
     cg.add(var.set_retry_interval(component.get_retry_interval()))
     cg.add(var.set_retry_count(component.get_retry_count()))
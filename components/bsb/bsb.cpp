@@ -6,17 +6,78 @@
 #include "bsbSensor.h"
 #include "esphome/core/hal.h"
 #include "esphome/core/log.h"
+#ifdef USE_API
+  #include "esphome/components/api/api_server.h"
+#endif
+#ifdef USE_MQTT
+  #include "esphome/components/mqtt/mqtt_client.h"
+#endif
+#include <algorithm>
 #include <cstdio>
 #include <cstring>
 
+#ifdef USE_BSB_ALLOCATION_AUDIT
+  #include <cstdlib>
+  #include <new>
+#endif
+
 namespace esphome {
   namespace bsb {
 
     const char* const TAG = "bsb.component";
 
+#ifdef USE_BSB_ALLOCATION_AUDIT
+    std::atomic< uint32_t > BsbAllocationCounters::allocations( 0 );
+    std::atomic< uint32_t > BsbAllocationCounters::bytes( 0 );
+    BsbAllocationScope*     BsbAllocationScope::current_ = nullptr;
+#endif
+
     BsbComponent::BsbComponent() {}
 
-    void BsbComponent::setup() { ESP_LOGCONFIG( TAG, "Setting up BSB component..." ); }
+    void BsbComponent::setup() {
+      ESP_LOGCONFIG( TAG, "Setting up BSB component..." );
+
+      if( interval_scale_ != 1 ) {
+        apply_interval_scale();
+      }
+      assign_pollers();
+      if( restore_ ) {
+        restore_settings();
+      }
+
+#ifdef USE_BINARY_SENSOR
+      if( link_sensor_ != nullptr ) {
+        link_sensor_->publish_initial_state( !link_health_.is_down() );
+      }
+#endif
+
+      if( snapshot_interval_ != 0 ) {
+        set_interval( "snapshot", snapshot_interval_, [this]() { publish_snapshot(); } );
+      }
+
+#ifdef USE_BSB_ALLOCATION_AUDIT
+      set_interval( "allocation_audit", IntervalAllocationAudit, [this]() { publish_allocation_audit(); } );
+#endif
+
+      if( !passive_ ) {
+        set_interval( "collisions", IntervalLogCollisions, [this]() { log_collisions(); } );
+      }
+
+      if( load_shedding_ && !passive_ ) {
+        set_interval( "load_shedding", BsbLoadGovernor::Window, [this]() { update_shedding(); } );
+        if( shedding_level_sensor_ != nullptr ) {
+          shedding_level_sensor_->publish_state( 0 );
+        }
+      }
+
+      if( idle_multiplier_ != 1 && !passive_ ) {
+        set_interval( "consumers", IntervalCheckConsumers, [this]() { check_consumers(); } );
+      }
+
+      if( passive_ ) {
+        set_interval( "refresh_rates", IntervalLogRefreshRates, [this]() { log_refresh_rates(); } );
+      }
+    }
 
     void BsbComponent::dump_config() {
       ESP_LOGCONFIG( TAG, "BSB:" );
@@ -24,6 +85,33 @@ namespace esphome {
       ESP_LOGCONFIG( TAG, "  retry interval: %.3fs", this->retry_interval_ / 1000.0f );
       ESP_LOGCONFIG( TAG, "  source address: 0x%02X", this->source_address_ );
       ESP_LOGCONFIG( TAG, "  destination address: 0x%02X", this->destination_address_ );
+      ESP_LOGCONFIG( TAG, "  passive: %s", YESNO( this->passive_ ) );
+      ESP_LOGCONFIG( TAG, "  multi-bus: %s", YESNO( this->multi_bus_ ) );
+      if( !this->passive_ ) {
+        ESP_LOGCONFIG( TAG,
+                       "  bus budget: %.2f transactions/s, %.0f%% utilization",
+                       this->bus_transactions_per_second_,
+                       this->bus_utilization_ * 100.0f );
+        if( this->interval_scale_ != 1 ) {
+          ESP_LOGCONFIG( TAG, "  update intervals scaled by: %.2f", this->interval_scale_ );
+        }
+        ESP_LOGCONFIG( TAG, "  slot alignment: %s", YESNO( this->slot_alignment_ ) );
+        ESP_LOGCONFIG( TAG, "  load shedding: %s", YESNO( this->load_shedding_ ) );
+        if( this->idle_multiplier_ != 1 ) {
+          ESP_LOGCONFIG( TAG, "  update intervals without consumer scaled by: %.2f", this->idle_multiplier_ );
+        }
+      }
+      ESP_LOGCONFIG( TAG, "  restore runtime changes: %s", YESNO( this->restore_ ) );
+      if( this->snapshot_interval_ != 0 ) {
+        ESP_LOGCONFIG( TAG, "  snapshot interval: %.3fs", this->snapshot_interval_ / 1000.0f );
+      }
+
+      for( const BsbGroup* group : groups_ ) {
+        ESP_LOGCONFIG( TAG, "  Group:" );
+        ESP_LOGCONFIG( TAG, "    members: %zu", group->size() );
+        ESP_LOGCONFIG( TAG, "    update_interval: %.3fs", group->get_update_interval() / 1000.0f );
+        ESP_LOGCONFIG( TAG, "    timeout: %.3fs", group->get_timeout() / 1000.0f );
+      }
 
       ESP_LOGCONFIG( TAG, "  Sensors:" );
       for( const auto& item : sensors_ ) {
@@ -34,6 +122,9 @@ namespace esphome {
             ESP_LOGCONFIG( TAG, "  - type: Sensor" );
             ESP_LOGCONFIG( TAG, "    factor: %.3f", ( ( BsbSensor* )s )->get_factor() );
             ESP_LOGCONFIG( TAG, "    divisor: %.3f", ( ( BsbSensor* )s )->get_divisor() );
+            if( ( ( BsbSensor* )s )->get_aggregate_window() ) {
+              ESP_LOGCONFIG( TAG, "    aggregate window: %.3fs", ( ( BsbSensor* )s )->get_aggregate_window() / 1000.0f );
+            }
             break;
 
 #ifdef USE_TEXT_SENSOR
@@ -48,8 +139,21 @@ namespace esphome {
             break;
 #endif
         }
+        ESP_LOGCONFIG( TAG, "    value type: %s", s->get_value_type_name() );
         ESP_LOGCONFIG( TAG, "    field ID: 0x%08X", s->get_field_id() );
-        ESP_LOGCONFIG( TAG, "    update_interval: %.3fs", s->get_update_interval() / 1000.0f );
+        if( s->get_priority() != BsbPriority::Normal ) {
+          ESP_LOGCONFIG( TAG, "    priority: %s", bsb_priority_name( s->get_priority() ) );
+        }
+        if( s->get_bitfield().is_set() ) {
+          ESP_LOGCONFIG( TAG, "    bitfield: mask 0x%08X, shift %u", s->get_bitfield().mask, s->get_bitfield().shift );
+        }
+        if( s->get_group() != nullptr ) {
+          ESP_LOGCONFIG( TAG, "    polled by its group" );
+        } else if( !s->is_polled() ) {
+          ESP_LOGCONFIG( TAG, "    polled by another entity with the same field ID" );
+        } else {
+          ESP_LOGCONFIG( TAG, "    update_interval: %.3fs", s->get_update_interval() / 1000.0f );
+        }
       }
       ESP_LOGCONFIG( TAG, "  Numbers:" );
       for( const auto& item : numbers_ ) {
@@ -61,6 +165,11 @@ namespace esphome {
             ESP_LOGCONFIG( TAG, "    factor: %.3f", ( ( BsbNumber* )n )->get_factor() );
             ESP_LOGCONFIG( TAG, "    divisor: %.3f", ( ( BsbNumber* )n )->get_divisor() );
             ESP_LOGCONFIG( TAG, "    broadcast: %s", YESNO( ( ( BsbNumber* )n )->get_broadcast() ) );
+            ESP_LOGCONFIG( TAG, "    verify after set: %s", YESNO( n->get_verify_after_set() ) );
+            if( n->get_broadcast() ) {
+              ESP_LOGCONFIG( TAG, "    broadcast interval: %.3fs", n->get_broadcast_interval() / 1000.0f );
+              ESP_LOGCONFIG( TAG, "    broadcast min gap: %.3fs", n->get_broadcast_min_gap() / 1000.0f );
+            }
             break;
 
 #ifdef USE_SWITCH
@@ -70,122 +179,652 @@ namespace esphome {
             ESP_LOGCONFIG( TAG, "    off_value: %02X", ( ( BsbSwitch* )n )->get_off_value() );
             break;
 #endif
+
+#ifdef USE_SELECT
+          case NumberType::Select:
+            ESP_LOGCONFIG( TAG, "  - type: Select" );
+            break;
+#endif
         }
+        ESP_LOGCONFIG( TAG, "    value type: %s", n->get_value_type_name() );
         ESP_LOGCONFIG( TAG, "    field ID: 0x%08X", n->get_field_id() );
-        ESP_LOGCONFIG( TAG, "    update_interval: %.3fs", n->get_update_interval() / 1000.0f );
+        if( n->get_priority() != BsbPriority::Normal ) {
+          ESP_LOGCONFIG( TAG, "    priority: %s", bsb_priority_name( n->get_priority() ) );
+        }
+        if( !n->get_broadcast() && !n->is_polled() ) {
+          ESP_LOGCONFIG( TAG, "    polled by another entity with the same field ID" );
+        } else {
+          ESP_LOGCONFIG( TAG, "    update_interval: %.3fs", n->get_update_interval() / 1000.0f );
+        }
       }
     }
 
     void BsbComponent::loop() {
-      const uint32_t now = millis();
+      // in multi-bus mode, the engine runs the bus
+      if( !multi_bus_ ) {
+        run( millis() );
+      }
+    }
+
+    void BsbComponent::run( const uint32_t now ) {
+      // the CPU time is only measured if it is published
+      const bool measure = loop_time_sensor_ != nullptr;
+      if( measure ) {
+        loop_load_.begin( micros() );
+      }
+
+      // nothing to do until the UART received something or the next deadline passed
+      if( has_received() || ( now - idle_since_ ) >= idle_for_ ) {
+        receive( now );
+        if( !passive_ ) {
+          BsbAllocationScope scope( allocations_send_ );
+          send_next_telegram( now );
+        }
+        schedule_wakeup( now );
+      }
+
+      if( measure && loop_load_.end( micros(), now ) ) {
+        loop_time_sensor_->publish_state( loop_load_.get_busy_per_second() );
+      }
+    }
+
+    const bool BsbComponent::has_received() { return this->available() != 0; }
+
+    const int32_t BsbComponent::get_slack( const uint32_t now ) {
+      if( has_received() ) {
+        return INT32_MIN;
+      }
+      return int32_t( idle_since_ + idle_for_ - now );
+    }
+
+    const size_t BsbComponent::read_chunk() {
+      const size_t length = std::min< size_t >( this->available(), RxChunk );
+      return ( length != 0 && this->read_array( rx_buffer_, length ) ) ? length : 0;
+    }
+
+    void BsbComponent::receive( const uint32_t now ) {
+      // read in chunks instead of byte by byte, the UART driver buffers the bytes in between
+      size_t length;
+      while( ( length = read_chunk() ) != 0 ) {
+        for( size_t i = 0; i < length; ++i ) {
+          bsbPacketReceive.loop( rx_buffer_[i] ^ 0xff );
+        }
+
+        // a garbled frame while our request is in flight
+        if( bsbPacketReceive.get_crc_errors() != crc_errors_ ) {
+          crc_errors_ = bsbPacketReceive.get_crc_errors();
+          slots_.frame_corrupted();
+        }
+
+        if( capture_callback_.size() != 0 ) {
+          capture_.clear();
+          BsbCapture::append_record( capture_, now, rx_buffer_, length );
+          capture_callback_.call( capture_ );
+        }
+      }
+    }
+
+    void BsbComponent::send_next_telegram( const uint32_t now ) {
+      if( link_health_.check_timeout( now ) ) {
+        link_state_changed( now );
+      }
+      refreshes_.expire( now );
+      slots_.check_timeout( now );
+      governor_.check_timeout( now );
+
+      // a slot the bus is predicted to be busy in is deferred, not skipped
+      const bool slot = bsb_deadline_passed( now, last_query_ + 1 ) && !is_group_waiting( now ) && is_slot_clear( now );
+
+      // broadcasts and Sets are served first, so they keep their latency regardless of the backlog of the polls. They go
+      // in between the Gets of a running group, only its pending reply is waited for. The broadcasts don't need a reply,
+      // so they go on while the link is down, else the heating system drops their values.
+      if( slot ) {
+        bool packetSent = send_broadcast( now );
+
+        // while the heating system doesn't answer, only a probe is sent now and then instead of all the pending telegrams
+        if( link_health_.is_down() ) {
+          last_query_ = now + query_interval_;
+          if( !packetSent && probe_field_id_ != 0 && link_health_.is_probe_due( now ) ) {
+            link_health_.probe_sent( now );
+            write_packet( bsb_build_get( tx_packet_, source_address_, destination_address_, probe_field_id_ ) );
+          }
+          return;
+        }
+
+        if( !packetSent ) {
+          packetSent = send_set( now );
+        }
+        if( packetSent ) {
+          last_query_ = now + query_interval_;
+          return;
+        }
+      }
 
-      while( this->available() ) {
-        bsbPacketReceive.loop( this->read() ^ 0xff );
+      if( link_health_.is_down() ) {
+        return;
       }
 
-      if( now > last_query_ ) {
+      // a running group is paced by the replies instead of the query interval, no polls are sent in between
+      if( continue_group( now ) ) {
+        return;
+      }
+
+      if( slot ) {
         last_query_ = now + query_interval_;
 
-        bool packetSent = false;
+        // the refreshes come after the Sets, but ahead of the regular polls; the ones of fields before the ones of groups
+        BsbRefreshQueue::Refresh* refresh = refreshes_.next();
+        if( refresh != nullptr ) {
+          write_packet( bsb_build_get( tx_packet_, source_address_, destination_address_, refresh->field_id ) );
+          refreshes_.sent( refresh, now );
+        } else if( !start_refreshed_group( now ) ) {
+          send_get( now );
+        }
+      }
+    }
+
+    bool BsbComponent::send_get( const uint32_t now ) {
+      // the higher priorities first, pe after a resync; within a priority the groups, then the numbers
+      for( const BsbPriority priority : { BsbPriority::Critical, BsbPriority::Normal, BsbPriority::Background } ) {
+        if( start_group( now, priority ) ) {
+          return true;
+        }
 
         for( auto& number : numbers_ ) {
-          if( number.second->is_ready_to_set( now ) ) {
-            write_packet( number.second->createPackageSet( source_address_, destination_address_ ) );
+          if( !number.second->get_broadcast() && number.second->get_priority() == priority && number.second->is_ready_to_update( now ) ) {
+            write_packet( number.second->createPackageGet( tx_packet_, source_address_, destination_address_ ) );
+            return true;
+          }
+        }
+
+        for( auto& sensor : sensors_ ) {
+          if( sensor.second->get_group() == nullptr && sensor.second->get_priority() == priority && sensor.second->is_ready( now ) ) {
+            write_packet( sensor.second->createPackageGet( tx_packet_, source_address_, destination_address_ ) );
+            return true;
+          }
+        }
+      }
+
+      return false;
+    }
 
-            if( number.second->get_broadcast() ) {
-              number.second->reset_dirty();
-              number.second->publish();
+    void BsbComponent::schedule_wakeup( const uint32_t now ) {
+      uint32_t idle  = MaxIdle;
+      uint32_t sweep = BsbNoDeadline;
+
+      if( !passive_ ) {
+        idle = std::min( idle, link_health_.get_time_until_due( now ) );
+        idle = std::min( idle, slots_.get_time_until_due( now ) );
+
+        for( const BsbNumberBase* number : broadcasts_ ) {
+          idle = std::min( idle, number->get_time_until_due( now ) );
+        }
+
+        // while the link is down, only the probe and the broadcasts are sent
+        if( !link_health_.is_down() ) {
+          idle = std::min( idle, refreshes_.get_time_until_due( now ) );
+          for( const auto& number : numbers_ ) {
+            if( !number.second->get_broadcast() ) {
+              idle = std::min( idle, number.second->get_time_until_due( now ) );
+            }
+          }
+          for( const auto& sensor : sensors_ ) {
+            if( sensor.second->get_group() == nullptr ) {
+              idle = std::min( idle, sensor.second->get_time_until_due( now ) );
+            }
+          }
+          for( const BsbGroup* group : groups_ ) {
+            if( group->is_active() ) {
+              sweep = std::min( sweep, group->get_time_until_due( now, query_interval_ ) );
             } else {
-              number.second->schedule_next_update( now, IntervalGetAfterSet );
+              idle = std::min( idle, group->get_time_until_due( now ) );
             }
+          }
+        }
 
-            packetSent = true;
-            break;
+        // the next telegram can't be sent before the next query slot, except the ones of a running group
+        idle = std::max( idle, bsb_time_until( now, last_query_ + 1 ) );
+        idle = std::min( idle, sweep );
+
+        // and not before the bus is predicted to be free
+        if( slot_alignment_ && !link_health_.is_down() ) {
+          idle = std::max( idle, slots_.get_time_until_clear( now ) );
+        }
+      }
+
+      idle_since_ = now;
+      idle_for_   = idle;
+    }
+
+    void BsbComponent::apply_interval_scale() {
+      for( auto& sensor : sensors_ ) {
+        if( sensor.second->get_update_interval() != SCHEDULER_DONT_RUN ) {
+          sensor.second->set_update_interval( sensor.second->get_update_interval() * interval_scale_ );
+        }
+      }
+
+      for( BsbGroup* group : groups_ ) {
+        group->set_update_interval( group->get_update_interval() * interval_scale_ );
+      }
+
+      // the broadcasts are kept, as the heating system drops their values if they aren't refreshed
+      for( auto& number : numbers_ ) {
+        if( !number.second->get_broadcast() && number.second->get_update_interval() != SCHEDULER_DONT_RUN ) {
+          number.second->set_update_interval( number.second->get_update_interval() * interval_scale_ );
+        }
+      }
+    }
+
+    void BsbComponent::assign_pollers() {
+      for( const auto& field : values_ ) {
+        assign_poller( field.first );
+      }
+    }
+
+    void BsbComponent::assign_poller( const uint32_t field_id ) {
+      BsbSensorBase* sensor_poller = nullptr;
+      BsbNumberBase* number_poller = nullptr;
+      BsbPriority    priority      = BsbPriority::Background;
+      uint32_t       interval      = 0;
+
+      // the highest priority polls, so the load shedding never stretches a field a critical entity needs; within a
+      // priority the shortest interval
+      auto better = [&]( const BsbPriority candidate_priority, const uint32_t candidate_interval, const bool number ) {
+        if( sensor_poller == nullptr && number_poller == nullptr ) {
+          return true;
+        }
+        if( candidate_priority != priority ) {
+          return candidate_priority < priority;
+        }
+        // a number is preferred on the same interval, as it reads back its value after a Set anyway
+        return number ? candidate_interval <= interval : candidate_interval < interval;
+      };
+
+      // the members of groups are polled by their group and the broadcasts aren't polled at all
+      auto sensors = sensors_.equal_range( field_id );
+      for( auto sensor = sensors.first; sensor != sensors.second; ++sensor ) {
+        if( sensor->second->get_group() != nullptr ) {
+          continue;
+        }
+        if( better( sensor->second->get_priority(), sensor->second->get_update_interval(), false ) ) {
+          sensor_poller = sensor->second;
+          number_poller = nullptr;
+          priority      = sensor->second->get_priority();
+          interval      = sensor->second->get_update_interval();
+        }
+      }
+
+      auto numbers = numbers_.equal_range( field_id );
+      for( auto number = numbers.first; number != numbers.second; ++number ) {
+        if( number->second->get_broadcast() ) {
+          continue;
+        }
+        if( better( number->second->get_priority(), number->second->get_update_interval(), true ) ) {
+          sensor_poller = nullptr;
+          number_poller = number->second;
+          priority      = number->second->get_priority();
+          interval      = number->second->get_update_interval();
+        }
+      }
+
+      // a paused field isn't polled at all
+      auto settings = field_settings_.find( field_id );
+      if( settings != field_settings_.end() && settings->second.paused ) {
+        sensor_poller = nullptr;
+        number_poller = nullptr;
+      }
+
+      for( auto sensor = sensors.first; sensor != sensors.second; ++sensor ) {
+        sensor->second->set_polled( sensor->second == sensor_poller );
+      }
+      for( auto number = numbers.first; number != numbers.second; ++number ) {
+        number->second->set_polled( number->second == number_poller );
+      }
+    }
+
+    void BsbComponent::change_query_interval( uint32_t query_interval ) {
+      ESP_LOGI( TAG, "Query interval: %.3fs", query_interval / 1000.0f );
+      query_interval_ = query_interval;
+      if( bsb_time_until( millis(), last_query_ ) > query_interval ) {
+        last_query_ = millis() + query_interval;
+      }
+
+      if( restore_ ) {
+        ESPPreferenceObject preference = global_preferences->make_preference< uint32_t >( preference_hash_ );
+        preference.save( &query_interval_ );
+      }
+      wake();
+    }
+
+    void BsbComponent::set_field_update_interval( uint32_t field_id, uint32_t update_interval ) {
+      if( values_.get( field_id ) == nullptr ) {
+        ESP_LOGW( TAG, "Field ID 0x%08X: not used by any entity", field_id );
+        return;
+      }
+      ESP_LOGI( TAG, "Field ID 0x%08X: update interval %.3fs", field_id, update_interval / 1000.0f );
+
+      BsbFieldSettings& settings = field_settings_[field_id];
+      settings.update_interval   = update_interval;
+      apply_field_settings( field_id, settings );
+      save_field_settings( field_id );
+    }
+
+    void BsbComponent::set_field_paused( uint32_t field_id, bool paused ) {
+      if( values_.get( field_id ) == nullptr ) {
+        ESP_LOGW( TAG, "Field ID 0x%08X: not used by any entity", field_id );
+        return;
+      }
+      ESP_LOGI( TAG, "Field ID 0x%08X: %s", field_id, paused ? "paused" : "resumed" );
+
+      BsbFieldSettings& settings = field_settings_[field_id];
+      settings.paused            = paused;
+      apply_field_settings( field_id, settings );
+      save_field_settings( field_id );
+    }
+
+    void BsbComponent::apply_field_settings( const uint32_t field_id, const BsbFieldSettings& settings ) {
+      const uint32_t now = millis();
+
+      // the field is polled right away, so a new interval counts from now on and a resumed field gets a fresh value
+      auto sensors = sensors_.equal_range( field_id );
+      for( auto sensor = sensors.first; sensor != sensors.second; ++sensor ) {
+        if( settings.update_interval != 0 ) {
+          sensor->second->set_update_interval( settings.update_interval );
+        }
+        sensor->second->reset_retries( now );
+      }
+      auto numbers = numbers_.equal_range( field_id );
+      for( auto number = numbers.first; number != numbers.second; ++number ) {
+        if( !number->second->get_broadcast() ) {
+          if( settings.update_interval != 0 ) {
+            number->second->set_update_interval( settings.update_interval );
           }
-          if( number.second->is_ready_to_update( now ) ) {
-            if( !number.second->get_broadcast() ) {
-              write_packet( number.second->createPackageGet( source_address_, destination_address_ ) );
+          number->second->reset_retries( now );
+        }
+      }
 
-              packetSent = true;
-              break;
-            }
+      assign_poller( field_id );
+      wake();
+    }
+
+    ESPPreferenceObject BsbComponent::make_field_preference( const uint32_t field_id ) {
+      return global_preferences->make_preference< BsbFieldSettings >( preference_hash_ ^ field_id );
+    }
+
+    void BsbComponent::save_field_settings( const uint32_t field_id ) {
+      if( restore_ ) {
+        ESPPreferenceObject preference = make_field_preference( field_id );
+        preference.save( &field_settings_[field_id] );
+      }
+    }
+
+    void BsbComponent::restore_settings() {
+      uint32_t            query_interval;
+      ESPPreferenceObject preference = global_preferences->make_preference< uint32_t >( preference_hash_ );
+      if( preference.load( &query_interval ) && query_interval != 0 ) {
+        query_interval_ = query_interval;
+      }
+
+      for( const auto& field : values_ ) {
+        BsbFieldSettings settings;
+        preference = make_field_preference( field.first );
+        if( preference.load( &settings ) ) {
+          field_settings_[field.first] = settings;
+          apply_field_settings( field.first, settings );
+        }
+      }
+    }
+
+    void BsbComponent::resync( const uint32_t now ) {
+      // everything is due at once, send_get() serves it in the order of the priorities
+      for( auto& number : numbers_ ) {
+        number.second->reset_retries( now );
+      }
+      for( auto& sensor : sensors_ ) {
+        sensor.second->reset_retries( now );
+      }
+      // not as refreshes, they would publish a latency nobody asked for and swallow the real requests meanwhile
+      for( BsbGroup* group : groups_ ) {
+        group->make_due();
+      }
+      wake();
+    }
+
+    const bool BsbComponent::has_consumer() const {
+#ifdef USE_API
+      if( api::global_api_server != nullptr && api::global_api_server->is_connected() ) {
+        return true;
+      }
+#endif
+#ifdef USE_MQTT
+      if( mqtt::global_mqtt_client != nullptr && mqtt::global_mqtt_client->is_connected() ) {
+        return true;
+      }
+#endif
+      return false;
+    }
+
+    void BsbComponent::check_consumers() {
+      const bool consumer = has_consumer();
+      if( consumer == consumer_ ) {
+        return;
+      }
+      consumer_ = consumer;
+
+      // the new interval takes effect with the next update of every field, on reconnect everything is polled at once
+      poll_scale_ = consumer ? 1 : idle_multiplier_;
+      apply_group_scales();
+
+      if( consumer ) {
+        ESP_LOGI( TAG, "Consumer connected, polling at the full rate" );
+        resync( millis() );
+      } else {
+        ESP_LOGI( TAG, "No consumer connected, stretching the update intervals by %.1f", idle_multiplier_ );
+      }
+    }
+
+    void BsbComponent::apply_group_scales() {
+      for( BsbGroup* group : groups_ ) {
+        group->set_interval_scale( get_poll_scale( group->get_priority() ) );
+      }
+    }
+
+    void BsbComponent::update_shedding() {
+      if( !governor_.evaluate( millis() ) ) {
+        return;
+      }
+
+      ESP_LOGI( TAG,
+                "Load shedding level %u: bus utilization %.0f%%, reply latency %ums, %.0f%% replies lost",
+                governor_.get_level(),
+                governor_.get_utilization() * 100.0f,
+                governor_.get_latency(),
+                governor_.get_loss() * 100.0f );
+      apply_group_scales();
+
+      // the pending updates move to the new level right away, a field stretched before is polled again as soon as
+      // the bus recovered
+      for( auto& sensor : sensors_ ) {
+        sensor.second->reschedule( get_poll_scale( sensor.second->get_priority() ) );
+      }
+      for( auto& number : numbers_ ) {
+        number.second->reschedule( get_poll_scale( number.second->get_priority() ) );
+      }
+      wake();
+
+      if( shedding_level_sensor_ != nullptr ) {
+        shedding_level_sensor_->publish_state( governor_.get_level() );
+      }
+    }
+
+    void BsbComponent::link_state_changed( const uint32_t now ) {
+      const BsbLinkState state = link_health_.get_state();
+      ESP_LOGW( TAG, "Link to 0x%02X: %s", destination_address_, BsbLinkHealth::state_name( state ) );
+
+      if( state == BsbLinkState::Recovering ) {
+        resync( now );
+      }
+
+#ifdef USE_BINARY_SENSOR
+      if( link_sensor_ != nullptr ) {
+        link_sensor_->publish_state( !link_health_.is_down() );
+      }
+#endif
+    }
+
+    bool BsbComponent::start_group( const uint32_t now, const BsbPriority priority ) {
+      for( BsbGroup* group : groups_ ) {
+        if( group->size() != 0 && group->get_priority() == priority && group->is_due( now ) ) {
+          start_sweep( group, now );
+          return true;
+        }
+      }
+
+      return false;
+    }
+
+    bool BsbComponent::start_refreshed_group( const uint32_t now ) {
+      for( BsbGroup* group : groups_ ) {
+        if( group->size() != 0 && group->is_refresh_requested() && !group->is_active() ) {
+          start_sweep( group, now );
+          return true;
+        }
+      }
+
+      return false;
+    }
+
+    void BsbComponent::start_sweep( BsbGroup* group, const uint32_t now ) {
+      group->start( now );
+      BsbSensorBase* member = group->next_member();
+      write_packet( member->createPackageGet( tx_packet_, source_address_, destination_address_ ) );
+      group->member_sent( now );
+    }
+
+    bool BsbComponent::continue_group( const uint32_t now ) {
+      for( BsbGroup* group : groups_ ) {
+        if( !group->is_active() ) {
+          continue;
+        }
+
+        if( group->is_complete( now ) ) {
+          const bool refresh = group->is_refresh_requested();
+
+          size_t missing;
+          {
+            BsbAllocationScope scope( allocations_publish_ );
+            missing = group->finish( now );
+          }
+          if( refresh ) {
+            refreshed( now - group->get_refresh_timestamp() );
           }
+          if( missing != 0 ) {
+            ESP_LOGW( TAG, "Group: %zu of %zu members didn't answer in time", missing, group->size() );
+          }
+          continue;
         }
 
-        if( !packetSent ) {
-          for( auto& sensor : sensors_ ) {
-            if( sensor.second->is_ready( now ) ) {
-              write_packet( sensor.second->createPackageGet( source_address_, destination_address_ ) );
+        BsbSensorBase* member = group->next_member();
+        if( member != nullptr && group->is_ready_to_send( now, query_interval_ ) && is_slot_clear( now ) ) {
+          write_packet( member->createPackageGet( tx_packet_, source_address_, destination_address_ ) );
+          group->member_sent( now );
+        }
+        return true;
+      }
 
-              break;
-            }
+      return false;
+    }
+
+    bool BsbComponent::send_set( const uint32_t now ) {
+      for( auto& number : numbers_ ) {
+        if( !number.second->get_broadcast() && number.second->is_ready_to_set( now ) ) {
+          write_packet( number.second->createPackageSet( tx_packet_, source_address_, destination_address_ ) );
+          if( number.second->get_verify_after_set() ) {
+            number.second->schedule_next_update( now, IntervalGetAfterSet );
           }
+
+          return true;
         }
       }
+
+      return false;
+    }
+
+    const bool BsbComponent::is_group_waiting( const uint32_t now ) const {
+      for( const BsbGroup* group : groups_ ) {
+        if( group->is_active() && !group->is_ready_to_send( now, query_interval_ ) ) {
+          return true;
+        }
+      }
+
+      return false;
+    }
+
+    bool BsbComponent::send_broadcast( const uint32_t now ) {
+      for( BsbNumberBase* number : broadcasts_ ) {
+        if( number->is_ready_to_broadcast( now ) ) {
+          write_packet( number->createPackageSet( tx_packet_, source_address_, destination_address_ ) );
+          number->broadcast_sent( now );
+
+          BsbAllocationScope scope( allocations_publish_ );
+          number->publish();
+
+          return true;
+        }
+      }
+
+      return false;
     }
 
     void BsbComponent::callback_packet( const BsbPacket* packet ) {
-      ESP_LOGD( TAG, "<<< %s", ( packet->print_packet() ).c_str() );
+      BsbAllocationScope scope( allocations_receive_ );
+
+#if ESPHOME_LOG_LEVEL >= ESPHOME_LOG_LEVEL_DEBUG
+      char line[BsbPacket::PrintSize];
+      ESP_LOGD( TAG, "<<< %s", packet->print_packet( line, sizeof( line ) ) );
+#endif
+
+      if( packet->sourceAddress == destination_address_ && packet->destinationAddress == source_address_ &&
+          ( packet->command == BsbPacket::Command::Ret || packet->command == BsbPacket::Command::Ack ||
+            packet->command == BsbPacket::Command::Nack ) ) {
+        if( link_health_.reply_received() ) {
+          link_state_changed( millis() );
+        }
+      }
+
+      governor_.frame_received( packet->buffer.size() );
+
+      // the frames of the other devices, our own ones are received as well
+      if( packet->sourceAddress == destination_address_ && packet->destinationAddress == source_address_ ) {
+        slots_.reply_received();
+        governor_.reply_received( millis() );
+      } else if( packet->sourceAddress != source_address_ ) {
+        slots_.observe( millis(), packet->sourceAddress, packet->fieldId, packet->buffer.size() );
+      }
+
+      if( packet->command == BsbPacket::Command::Ret && packet->destinationAddress == source_address_ ) {
+        for( BsbGroup* group : groups_ ) {
+          if( group->is_active() ) {
+            group->reply_received( packet->fieldId );
+          }
+        }
+      }
 
       if( packet->command == BsbPacket::Command::Inf || packet->command == BsbPacket::Command::Ret ) {
+        values_.update( packet, millis() );
+
         {
           auto range = sensors_.equal_range( packet->fieldId );
 
           for( auto sensor = range.first; sensor != range.second; ++sensor ) {
-            switch( sensor->second->get_type() ) {
-              case SensorType::Sensor: {
-                BsbSensor* bsbSensor = ( BsbSensor* )sensor->second;
-                bsbSensor->schedule_next_regular_update( millis() );
-                switch( bsbSensor->get_value_type() ) {
-                  case BsbSensorValueType::UInt8:
-                    bsbSensor->set_value( packet->parse_as_uint8() );
-                    break;
-                  case BsbSensorValueType::Int8:
-                    bsbSensor->set_value( packet->parse_as_int8() );
-                    break;
-                  case BsbSensorValueType::Int16:
-                    bsbSensor->set_value( packet->parse_as_int16() );
-                    break;
-                  case BsbSensorValueType::Int32:
-                    bsbSensor->set_value( packet->parse_as_int32() );
-                    break;
-                  case BsbSensorValueType::Temperature:
-                    bsbSensor->set_value( packet->parse_as_temperature() );
-                    break;
-                }
-                bsbSensor->publish();
-              } break;
-
-#ifdef USE_TEXT_SENSOR
-              case SensorType::TextSensor: {
-                BsbTextSensor* bsbSensor = ( BsbTextSensor* )sensor->second;
-                bsbSensor->schedule_next_regular_update( millis() );
-                bsbSensor->set_value( packet->parse_as_text() );
-                bsbSensor->publish();
-              } break;
-#endif
+            BsbSensorBase* bsbSensor = sensor->second;
+            bsbSensor->schedule_next_regular_update( millis(), get_poll_scale( bsbSensor->get_priority() ) );
+            bsbSensor->decode( packet );
 
-#ifdef USE_BINARY_SENSOR
-              case SensorType::BinarySensor: {
-                BsbBinarySensor* bsbSensor = ( BsbBinarySensor* )sensor->second;
-                bsbSensor->schedule_next_regular_update( millis() );
-                switch( bsbSensor->get_value_type() ) {
-                  case BsbSensorValueType::UInt8:
-                    bsbSensor->set_value( packet->parse_as_uint8() );
-                    break;
-                  case BsbSensorValueType::Int8:
-                    bsbSensor->set_value( packet->parse_as_int8() );
-                    break;
-                  case BsbSensorValueType::Int16:
-                    bsbSensor->set_value( packet->parse_as_int16() );
-                    break;
-                  case BsbSensorValueType::Int32:
-                    bsbSensor->set_value( packet->parse_as_int32() );
-                    break;
-                }
-                bsbSensor->publish();
-              } break;
-#endif
+            // the members of a running group are published together, when the group is complete
+            if( bsbSensor->get_group() == nullptr || !bsbSensor->get_group()->is_active() ) {
+              BsbAllocationScope scope( allocations_publish_ );
+              bsbSensor->publish();
             }
           }
         }
@@ -194,50 +833,196 @@ namespace esphome {
           auto range = numbers_.equal_range( packet->fieldId );
           for( auto number = range.first; number != range.second; ++number ) {
             BsbNumberBase* bsbNumber = number->second;
-            bsbNumber->schedule_next_regular_update( millis() );
-            switch( bsbNumber->get_value_type() ) {
-              case BsbNumberValueType::UInt8:
-                bsbNumber->set_value( packet->parse_as_uint8() );
-                break;
-              case BsbNumberValueType::Int8:
-                bsbNumber->set_value( packet->parse_as_int8() );
-                break;
-              case BsbNumberValueType::Int16:
-                bsbNumber->set_value( packet->parse_as_int16() );
-                break;
-              case BsbNumberValueType::Int32:
-                bsbNumber->set_value( packet->parse_as_int32() );
-                break;
-              case BsbNumberValueType::Temperature:
-                bsbNumber->set_value( packet->parse_as_temperature() );
-                break;
-              default:
-                break;
-            }
+            bsbNumber->schedule_next_regular_update( millis(), get_poll_scale( bsbNumber->get_priority() ) );
+            bsbNumber->decode( packet );
           }
         }
       }
 
+      // from the request to the publish, like the refreshes of the groups
+      if( packet->command == BsbPacket::Command::Ret && packet->destinationAddress == source_address_ ) {
+        uint32_t latency;
+        if( refreshes_.reply_received( packet->fieldId, millis(), latency ) ) {
+          refreshed( latency );
+        }
+      }
+
       if( packet->command == BsbPacket::Command::Ack || packet->command == BsbPacket::Command::Nack ) {
         auto range = numbers_.equal_range( packet->fieldId );
 
-        for( auto sensor = range.first; sensor != range.second; ++sensor ) {
-          sensor->second->reset_dirty();
+        for( auto number = range.first; number != range.second; ++number ) {
+          BsbNumberBase* bsbNumber = number->second;
+          bsbNumber->reset_dirty();
+
+          if( packet->command == BsbPacket::Command::Nack ) {
+            ESP_LOGW( TAG, "Set %08X: rejected by the heating system, restoring the last confirmed value", bsbNumber->get_field_id() );
+            if( !bsbNumber->set_rejected() ) {
+              // nothing confirmed yet, read the value of the heating system instead of publishing a guess
+              bsbNumber->reset_retries( millis() );
+            }
+          } else if( !bsbNumber->get_verify_after_set() ) {
+            // publish the written value right away, the Get after the Set is skipped
+            bsbNumber->set_acknowledged();
+          }
+        }
+      }
+    }
+
+    void BsbComponent::log_refresh_rates() {
+      ESP_LOGI( TAG, "Observed refresh rates:" );
+      for( const auto& item : values_ ) {
+        const BsbValue& value = item.second;
+        if( value.updates > 1 ) {
+          ESP_LOGI( TAG, "  field ID 0x%08X: every %.1fs (%u updates)", item.first, value.average_interval_ms / 1000.0f, value.updates );
+        } else if( value.updates == 1 ) {
+          ESP_LOGI( TAG, "  field ID 0x%08X: seen once", item.first );
+        } else {
+          ESP_LOGI( TAG, "  field ID 0x%08X: not seen on the bus", item.first );
         }
       }
     }
 
+    BsbCachedValue BsbComponent::get_cached( uint32_t field_id, uint32_t max_age ) {
+      const BsbValue* value = values_.get( field_id );
+      if( value == nullptr ) {
+        values_.add_field( field_id );
+        value = values_.get( field_id );
+      }
+
+      const BsbCachedValue cached( value, millis() );
+      if( max_age != 0 && cached.age > max_age ) {
+        request_refresh( field_id );
+      }
+      return cached;
+    }
+
+    void BsbComponent::request_refresh( uint32_t field_id ) {
+      if( !passive_ && refreshes_.request( field_id, millis() ) ) {
+        wake();
+      }
+    }
+
+    void BsbComponent::request_group_refresh( BsbGroup* group ) {
+      if( !passive_ && group->request_refresh( millis() ) ) {
+        wake();
+      }
+    }
+
+    void BsbComponent::refreshed( const uint32_t latency ) {
+      ESP_LOGD( TAG, "Refresh took %ums", latency );
+      if( refresh_latency_sensor_ != nullptr ) {
+        refresh_latency_sensor_->publish_state( latency );
+      }
+    }
+
+    const bool BsbComponent::is_slot_clear( const uint32_t now ) {
+      return !slot_alignment_ || link_health_.is_down() || slots_.check( now );
+    }
+
+    void BsbComponent::log_collisions() {
+      const BsbCollisionStats& unaligned = slots_.get_unaligned();
+      const BsbCollisionStats& aligned   = slots_.get_aligned();
+      ESP_LOGI( TAG,
+                "Collisions: %.1f%% of %u requests without alignment, %.1f%% of %u aligned requests",
+                unaligned.rate(),
+                unaligned.requests,
+                aligned.rate(),
+                aligned.requests );
+      if( slot_alignment_ ) {
+        ESP_LOGI( TAG,
+                  "  %u slots deferred, %u sent after the maximal deferral, guard %ums",
+                  slots_.get_deferrals(),
+                  slots_.get_fallbacks(),
+                  slots_.get_margin() );
+      }
+
+      const BsbCollisionStats window = slots_.take_window();
+      if( collision_rate_sensor_ != nullptr && window.requests != 0 ) {
+        collision_rate_sensor_->publish_state( window.rate() );
+      }
+    }
+
+    void BsbComponent::publish_allocation_audit() {
+      const BsbAllocationStats* stats[]  = { &allocations_receive_, &allocations_send_, &allocations_publish_ };
+      const char* const         labels[] = { "received telegrams", "sent telegrams", "publishes" };
+
+      uint32_t allocations = 0;
+      uint32_t bytes       = 0;
+      uint32_t high_water  = 0;
+
+      ESP_LOGD( TAG, "Heap allocations:" );
+      for( uint8_t i = 0; i < 3; ++i ) {
+        ESP_LOGD( TAG,
+                  "  %s: %u allocations, %u bytes in %u events, at most %u bytes at once",
+                  labels[i],
+                  stats[i]->allocations,
+                  stats[i]->bytes,
+                  stats[i]->events,
+                  stats[i]->high_water_bytes );
+        allocations += stats[i]->allocations;
+        bytes += stats[i]->bytes;
+        high_water = std::max( high_water, stats[i]->high_water_bytes );
+      }
+
+#ifdef USE_BSB_ALLOCATION_AUDIT
+      if( allocations_sensor_ != nullptr ) {
+        allocations_sensor_->publish_state( allocations );
+      }
+      if( allocated_bytes_sensor_ != nullptr ) {
+        allocated_bytes_sensor_->publish_state( bytes );
+      }
+      if( allocation_high_water_sensor_ != nullptr ) {
+        allocation_high_water_sensor_->publish_state( high_water );
+      }
+#endif
+    }
+
+    void BsbComponent::publish_snapshot() {
+      values_.snapshot( snapshot_, millis() );
+      ESP_LOGD( TAG, "Snapshot: %zu fields, %zu bytes", values_.size(), snapshot_.size() );
+      snapshot_callback_.call( snapshot_ );
+    }
+
     void BsbComponent::write_packet( const BsbPacket& packet ) {
       if( !packet.buffer.empty() ) {
-        ESP_LOGD( TAG, ">>> %s", ( packet.print_packet() ).c_str() );
+#if ESPHOME_LOG_LEVEL >= ESPHOME_LOG_LEVEL_DEBUG
+        char line[BsbPacket::PrintSize];
+        ESP_LOGD( TAG, ">>> %s", packet.print_packet( line, sizeof( line ) ) );
+#endif
 
-        auto buffer = packet.buffer;
-        for( auto& b : buffer ) {
+        if( packet.command == BsbPacket::Command::Get || packet.command == BsbPacket::Command::Set ) {
+          link_health_.request_sent( millis() );
+          slots_.request_sent( millis(), slot_alignment_ && slots_.is_predicting( millis() ) );
+          governor_.request_sent( millis() );
+        }
+
+        // into a member, so sending doesn't allocate
+        tx_buffer_.assign( packet.buffer.cbegin(), packet.buffer.cend() );
+        for( auto& b : tx_buffer_ ) {
           b ^= 0xff;
         }
-        write_array( buffer );
+        write_array( tx_buffer_ );
       }
     }
 
   } // namespace bsb
 } // namespace esphome
+
+#ifdef USE_BSB_ALLOCATION_AUDIT
+// counting replacements of the global allocation functions, the other variants of new and delete end up in these
+void* operator new( size_t size ) {
+  esphome::bsb::BsbAllocationCounters::allocations.fetch_add( 1, std::memory_order_relaxed );
+  esphome::bsb::BsbAllocationCounters::bytes.fetch_add( size, std::memory_order_relaxed );
+
+  void* ptr = malloc( size );
+  if( ptr == nullptr ) {
+    abort();
+  }
+  return ptr;
+}
+void* operator new[]( size_t size ) { return operator new( size ); }
+void  operator delete( void* ptr ) noexcept { free( ptr ); }
+void  operator delete[]( void* ptr ) noexcept { free( ptr ); }
+void  operator delete( void* ptr, size_t ) noexcept { free( ptr ); }
+void  operator delete[]( void* ptr, size_t ) noexcept { free( ptr ); }
+#endif
@@ -6,11 +6,23 @@
 #ifdef USE_BINARY_SENSOR
   #include "esphome/components/binary_sensor/binary_sensor.h"
 #endif
+#include "bsbAllocationAudit.h"
+#include "bsbCapture.h"
+#include "bsbGovernor.h"
+#include "bsbGroup.h"
+#include "bsbLinkHealth.h"
 #include "bsbNumber.h"
+#include "bsbRefresh.h"
+#include "bsbScheduling.h"
 #include "bsbSensor.h"
+#include "bsbSlots.h"
+#include "bsbValueStore.h"
+#include "esphome/core/helpers.h"
+#include "esphome/core/preferences.h"
 
 #include <cstdint>
 #include <unordered_map>
+#include <vector>
 
 #include "bsbPacketReceive.h"
 
@@ -38,24 +50,212 @@ namespace esphome {
 
       void set_query_interval( uint32_t val ) { query_interval_ = val; }
 
+      // Runtime tuning, see the actions in automation.h. With restore, the changes are saved to the preferences and
+      // applied again after a restart.
+      void set_restore( uint32_t preference_hash ) {
+        restore_         = true;
+        preference_hash_ = preference_hash;
+      }
+      void change_query_interval( uint32_t query_interval );
+      void set_field_update_interval( uint32_t field_id, uint32_t update_interval );
+      void set_field_paused( uint32_t field_id, bool paused );
+
       void           set_retry_interval( uint32_t val ) { retry_interval_ = val; }
       const uint32_t get_retry_interval() const { return retry_interval_; }
       void           set_retry_count( uint8_t val ) { retry_count_ = val; }
       const uint8_t  get_retry_count() const { return retry_count_; }
 
-      void register_sensor( BsbSensorBase* sensor ) { this->sensors_.insert( { sensor->get_field_id(), sensor } ); }
-      void register_number( BsbNumberBase* number ) { this->numbers_.insert( { number->get_field_id(), number } ); }
+      void set_snapshot_interval( uint32_t val ) { snapshot_interval_ = val; }
+
+      // computed at compile time from the intervals of all entities, see bus_budget() in __init__.py
+      void set_bus_budget( float transactions_per_second, float utilization ) {
+        bus_transactions_per_second_ = transactions_per_second;
+        bus_utilization_             = utilization;
+      }
+      void set_interval_scale( float val ) { interval_scale_ = val; }
+
+      // defer the telegrams into the gaps between the frames of the other devices, see bsbSlots.h
+      void set_slot_alignment( bool val ) { slot_alignment_ = val; }
+      void set_collision_rate_sensor( sensor::Sensor* sensor ) { collision_rate_sensor_ = sensor; }
+
+      // stretch the intervals of the background and normal entities while the bus is under pressure, see bsbGovernor.h
+      void set_load_shedding( float max_utilization ) {
+        load_shedding_ = true;
+        governor_.set_max_utilization( max_utilization );
+      }
+      void set_shedding_level_sensor( sensor::Sensor* sensor ) { shedding_level_sensor_ = sensor; }
+
+      // while no API or MQTT client is connected, the update intervals are stretched by the multiplier
+      void set_idle_multiplier( float val ) { idle_multiplier_ = val; }
+
+#ifdef USE_BINARY_SENSOR
+      void set_link_sensor( binary_sensor::BinarySensor* link_sensor ) { this->link_sensor_ = link_sensor; }
+#endif
+      const BsbLinkState get_link_state() const { return link_health_.get_state(); }
+
+      // CPU time spent in loop() per second, in ms
+      void set_loop_time_sensor( sensor::Sensor* loop_time_sensor ) { this->loop_time_sensor_ = loop_time_sensor; }
+
+#ifdef USE_BSB_ALLOCATION_AUDIT
+      // totals of the heap allocations in the telegram path and the largest one of a single telegram or publish, in bytes
+      void set_allocations_sensor( sensor::Sensor* val ) { this->allocations_sensor_ = val; }
+      void set_allocated_bytes_sensor( sensor::Sensor* val ) { this->allocated_bytes_sensor_ = val; }
+      void set_allocation_high_water_sensor( sensor::Sensor* val ) { this->allocation_high_water_sensor_ = val; }
+#endif
+
+      // leave the idle state in the next loop(), pe because a value has to be sent
+      void wake() { idle_for_ = 0; }
+
+      // Multi-bus mode: the bus is run by a BsbEngine together with the other buses instead of by its own loop(), see
+      // bsbEngine.h.
+      void attach_engine() { multi_bus_ = true; }
+      // one pass of the bus: receive, send and compute the next wakeup, called by loop() or the engine with the time of
+      // the pass
+      void run( const uint32_t now );
+      // ms until the bus has something to do, negative if it is overdue; INT32_MIN if it received bytes
+      const int32_t get_slack( const uint32_t now );
+
+      // only listen to the bus, never transmit anything
+      void       set_passive( bool val ) { passive_ = val; }
+      const bool get_passive() const { return passive_; }
+
+      // the field polled while the link is down, by default the first registered one
+      void set_probe_field_id( uint32_t val ) { probe_field_id_ = val; }
+
+      void register_sensor( BsbSensorBase* sensor ) {
+        if( probe_field_id_ == 0 ) {
+          probe_field_id_ = sensor->get_field_id();
+        }
+        this->sensors_.insert( { sensor->get_field_id(), sensor } );
+        this->values_.add_field( sensor->get_field_id() );
+      }
+      void register_number( BsbNumberBase* number ) {
+        if( probe_field_id_ == 0 && !number->get_broadcast() ) {
+          probe_field_id_ = number->get_field_id();
+        }
+        number->set_on_dirty( [this]() { wake(); } );
+        this->numbers_.insert( { number->get_field_id(), number } );
+        this->values_.add_field( number->get_field_id() );
+        if( number->get_broadcast() ) {
+          this->broadcasts_.push_back( number );
+        }
+      }
+
+      // The last value of a field seen on the bus, without going through the filters of the entities. If max_age is given
+      // and the value is older, the field is read ahead of the regular polls, the result is available on a later call.
+      // Fields which are not used by any entity are added to the store on the first call.
+      BsbCachedValue get_cached( uint32_t field_id, uint32_t max_age = 0 );
+
+      // reads the field or the group ahead of the regular polls, but after the pending Sets
+      void request_refresh( uint32_t field_id );
+      void request_group_refresh( BsbGroup* group );
+
+      // time from the request of a refresh to the publish of the value, in ms
+      void set_refresh_latency_sensor( sensor::Sensor* val ) { this->refresh_latency_sensor_ = val; }
+
+      void register_group( BsbGroup* group ) { this->groups_.push_back( group ); }
+
+      // packs the last payload of every registered field into one message, see BsbValueStore::snapshot()
+      void publish_snapshot();
+      void add_on_snapshot_callback( std::function< void( const std::vector< uint8_t >& ) >&& callback ) {
+        this->snapshot_callback_.add( std::move( callback ) );
+      }
+
+      // called with a record in the capture format (see bsbCapture.h) for every chunk of received bytes
+      void add_on_capture_callback( std::function< void( const std::vector< uint8_t >& ) >&& callback ) {
+        this->capture_callback_.add( std::move( callback ) );
+      }
 
     protected:
+      const bool   has_received();
+      const size_t read_chunk();
+      void         receive( const uint32_t now );
+
+      void send_next_telegram( const uint32_t now );
+
+      // computes how long loop() can idle: until the next entity is due, but not before the next query slot
+      void schedule_wakeup( const uint32_t now );
+
       void callback_packet( const BsbPacket* packet );
 
       void write_packet( const BsbPacket& packet );
 
+      bool send_broadcast( const uint32_t now );
+      bool send_set( const uint32_t now );
+      bool send_get( const uint32_t now );
+
+      // true while a running group waits for the reply to its last Get
+      const bool is_group_waiting( const uint32_t now ) const;
+
+      bool start_group( const uint32_t now, const BsbPriority priority );
+      // a group with a requested refresh, regardless of its priority
+      bool start_refreshed_group( const uint32_t now );
+      void start_sweep( BsbGroup* group, const uint32_t now );
+      // sends the next Get of a running group, returns true while a group is running
+      bool continue_group( const uint32_t now );
+
+      void log_refresh_rates();
+
+      void apply_interval_scale();
+
+      // only one entity per field ID polls, the one with the shortest update interval
+      void assign_pollers();
+      void assign_poller( const uint32_t field_id );
+
+      // changed at runtime, an update interval of 0 keeps the configured one
+      struct BsbFieldSettings {
+        uint32_t update_interval;
+        uint8_t  paused;
+      };
+
+      void                restore_settings();
+      void                apply_field_settings( const uint32_t field_id, const BsbFieldSettings& settings );
+      void                save_field_settings( const uint32_t field_id );
+      ESPPreferenceObject make_field_preference( const uint32_t field_id );
+
+      void link_state_changed( const uint32_t now );
+
+      // polls everything right away
+      void resync( const uint32_t now );
+
+      const bool has_consumer() const;
+      void       check_consumers();
+
+      // the stretch of the update intervals of an entity, for the missing consumers and the load shedding
+      const float get_poll_scale( const BsbPriority priority ) const { return poll_scale_ * governor_.get_scale( priority ); }
+      void        apply_group_scales();
+      void        update_shedding();
+
+      void publish_allocation_audit();
+
+      void refreshed( const uint32_t latency );
+
+      // true if the bus is predicted to be free for a transaction
+      const bool is_slot_clear( const uint32_t now );
+      void       log_collisions();
+
       BsbPacketReceive bsbPacketReceive = BsbPacketReceive( [&]( const BsbPacket* packet ) { callback_packet( packet ); } );
 
       SensorMap sensors_;
       NumberMap numbers_;
 
+      std::vector< BsbNumberBase* > broadcasts_;
+      std::vector< BsbGroup* >      groups_;
+      BsbRefreshQueue               refreshes_;
+      sensor::Sensor*               refresh_latency_sensor_ = nullptr;
+
+      BsbValueStore                                            values_;
+      std::vector< uint8_t >                                   snapshot_;
+      uint32_t                                                 snapshot_interval_ = 0;
+      CallbackManager< void( const std::vector< uint8_t >& ) > snapshot_callback_;
+
+      uint8_t rx_buffer_[32];
+      // the telegram being sent and its inverted bytes, reused so sending doesn't allocate
+      BsbPacket                                                tx_packet_;
+      std::vector< uint8_t >                                   tx_buffer_;
+      std::vector< uint8_t >                                   capture_;
+      CallbackManager< void( const std::vector< uint8_t >& ) > capture_callback_;
+
       uint32_t query_interval_;
       uint32_t retry_interval_;
       uint8_t  retry_count_;
@@ -63,10 +263,63 @@ namespace esphome {
       uint8_t source_address_;
       uint8_t destination_address_;
 
+      bool passive_   = false;
+      bool multi_bus_ = false;
+
+      std::unordered_map< uint32_t, BsbFieldSettings > field_settings_;
+      bool                                             restore_         = false;
+      uint32_t                                         preference_hash_ = 0;
+
+      float bus_transactions_per_second_ = 0;
+      float bus_utilization_             = 0;
+      float interval_scale_              = 1;
+
+      BsbSlotPlanner  slots_;
+      bool            slot_alignment_        = false;
+      uint32_t        crc_errors_            = 0;
+      sensor::Sensor* collision_rate_sensor_ = nullptr;
+
+      BsbLoadGovernor governor_;
+      bool            load_shedding_         = false;
+      sensor::Sensor* shedding_level_sensor_ = nullptr;
+
+      float idle_multiplier_ = 1;
+      float poll_scale_      = 1;
+      bool  consumer_        = true;
+
+      BsbLinkHealth link_health_;
+      // a field the heating system answers, to probe whether the link is back
+      uint32_t probe_field_id_ = 0;
+#ifdef USE_BINARY_SENSOR
+      binary_sensor::BinarySensor* link_sensor_ = nullptr;
+#endif
+
+      BsbAllocationStats allocations_receive_;
+      BsbAllocationStats allocations_send_;
+      BsbAllocationStats allocations_publish_;
+#ifdef USE_BSB_ALLOCATION_AUDIT
+      sensor::Sensor* allocations_sensor_           = nullptr;
+      sensor::Sensor* allocated_bytes_sensor_       = nullptr;
+      sensor::Sensor* allocation_high_water_sensor_ = nullptr;
+#endif
+
+      uint32_t        idle_since_       = 0;
+      uint32_t        idle_for_         = 0;
+      BsbLoopLoad     loop_load_;
+      sensor::Sensor* loop_time_sensor_ = nullptr;
+
     private:
       uint32_t last_query_ = 0;
 
-      static constexpr uint32_t IntervalGetAfterSet = 1000;
+      static constexpr uint32_t IntervalGetAfterSet     = 1000;
+      static constexpr uint32_t IntervalLogRefreshRates = 5 * 60 * 1000;
+      static constexpr uint32_t IntervalAllocationAudit = 60 * 1000;
+      static constexpr uint32_t IntervalCheckConsumers  = 1000;
+      static constexpr uint32_t IntervalLogCollisions   = 5 * 60 * 1000;
+      // also the maximal length of a capture record
+      static constexpr uint8_t  RxChunk                 = sizeof( rx_buffer_ );
+      // safety net, in case a deadline changed without waking the component
+      static constexpr uint32_t MaxIdle                 = 1000;
     };
 
   } // namespace bsb
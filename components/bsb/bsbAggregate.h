@@ -0,0 +1,64 @@
+#pragma once
+
+#include <cstdint>
+#include <memory>
+
+namespace esphome {
+  namespace bsb {
+    // fixed-size ring of samples, allocated once at configuration time. When it is full, the next sample overwrites the
+    // oldest one, so the owner closes its window before that, see BsbSensor::publish().
+    class BsbSampleRing {
+    public:
+      void set_capacity( const uint8_t capacity ) {
+        samples_.reset( new float[capacity] );
+        capacity_ = capacity;
+        clear();
+      }
+      const uint8_t get_capacity() const { return capacity_; }
+
+      void       clear() { size_ = head_ = 0; }
+      const bool empty() const { return size_ == 0; }
+      const bool full() const { return size_ == capacity_; }
+
+      void push( const float value ) {
+        samples_[head_] = value;
+        head_           = ( head_ + 1 ) % capacity_;
+        if( size_ < capacity_ ) {
+          ++size_;
+        }
+      }
+
+      const float last() const { return samples_[( head_ + capacity_ - 1 ) % capacity_]; }
+
+      const float min() const {
+        float result = samples_[0];
+        for( uint8_t i = 1; i < size_; ++i ) {
+          result = samples_[i] < result ? samples_[i] : result;
+        }
+        return result;
+      }
+
+      const float max() const {
+        float result = samples_[0];
+        for( uint8_t i = 1; i < size_; ++i ) {
+          result = samples_[i] > result ? samples_[i] : result;
+        }
+        return result;
+      }
+
+      const float mean() const {
+        float sum = 0;
+        for( uint8_t i = 0; i < size_; ++i ) {
+          sum += samples_[i];
+        }
+        return sum / size_;
+      }
+
+    private:
+      std::unique_ptr< float[] > samples_;
+      uint8_t                    capacity_ = 0;
+      uint8_t                    size_     = 0;
+      uint8_t                    head_     = 0;
+    };
+  }
+}
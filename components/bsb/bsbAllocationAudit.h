@@ -0,0 +1,85 @@
+#pragma once
+
+#include <cstdint>
+
+#ifdef USE_BSB_ALLOCATION_AUDIT
+  #include <atomic>
+#endif
+
+// Allocation audit: with USE_BSB_ALLOCATION_AUDIT, the global operator new is replaced by a counting one (see bsb.cpp)
+// and the heap allocations are attributed to the received telegrams, the sent telegrams and the publishes. Without it,
+// the scopes compile to nothing.
+//
+// The counters are global, so allocations of other tasks which happen at the same time are attributed as well. The
+// numbers are meant to find the paths which allocate at all, not to be exact.
+
+namespace esphome {
+  namespace bsb {
+    struct BsbAllocationStats {
+      uint32_t events           = 0;
+      uint32_t allocations      = 0;
+      uint32_t bytes            = 0;
+      uint32_t high_water_bytes = 0;
+
+      void add( const uint32_t event_allocations, const uint32_t event_bytes ) {
+        ++events;
+        allocations += event_allocations;
+        bytes += event_bytes;
+        if( event_bytes > high_water_bytes ) {
+          high_water_bytes = event_bytes;
+        }
+      }
+    };
+
+#ifdef USE_BSB_ALLOCATION_AUDIT
+    struct BsbAllocationCounters {
+      static std::atomic< uint32_t > allocations;
+      static std::atomic< uint32_t > bytes;
+    };
+
+    // counts the allocations until it goes out of scope, without the ones of nested scopes
+    class BsbAllocationScope {
+    public:
+      explicit BsbAllocationScope( BsbAllocationStats& stats )
+          : stats_( stats )
+          , parent_( current_ )
+          , allocations_( BsbAllocationCounters::allocations )
+          , bytes_( BsbAllocationCounters::bytes ) {
+        current_ = this;
+      }
+
+      ~BsbAllocationScope() {
+        const uint32_t allocations = BsbAllocationCounters::allocations - allocations_;
+        const uint32_t bytes       = BsbAllocationCounters::bytes - bytes_;
+
+        stats_.add( allocations - nested_allocations_, bytes - nested_bytes_ );
+
+        if( parent_ != nullptr ) {
+          parent_->nested_allocations_ += allocations;
+          parent_->nested_bytes_ += bytes;
+        }
+        current_ = parent_;
+      }
+
+      BsbAllocationScope( const BsbAllocationScope& )            = delete;
+      BsbAllocationScope& operator=( const BsbAllocationScope& ) = delete;
+
+    private:
+      BsbAllocationStats& stats_;
+      BsbAllocationScope* parent_;
+      uint32_t            allocations_;
+      uint32_t            bytes_;
+      uint32_t            nested_allocations_ = 0;
+      uint32_t            nested_bytes_       = 0;
+
+      // the scopes are only used in the main loop
+      static BsbAllocationScope* current_;
+    };
+#else
+    class BsbAllocationScope {
+    public:
+      explicit BsbAllocationScope( BsbAllocationStats& ) {}
+    };
+#endif
+  }
+}
@@ -0,0 +1,82 @@
+#pragma once
+
+#include <cstdint>
+#include <vector>
+
+#include "bsbPacketReceive.h"
+
+// Capture format for the raw traffic on the bus, exactly as read from the UART (still inverted):
+//   header: 'B', 'S', 'B', 'C', version
+//   record: timestamp in ms (uint32, big endian), length (uint8), raw bytes
+//
+// A capture is the header followed by any number of records.
+
+namespace esphome {
+  namespace bsb {
+    class BsbCapture {
+    public:
+      static void append_header( std::vector< uint8_t >& out ) {
+        out.push_back( 'B' );
+        out.push_back( 'S' );
+        out.push_back( 'B' );
+        out.push_back( 'C' );
+        out.push_back( Version );
+      }
+
+      static void append_record( std::vector< uint8_t >& out, const uint32_t timestamp, const uint8_t* data, const uint8_t length ) {
+        out.push_back( timestamp >> 24 );
+        out.push_back( timestamp >> 16 );
+        out.push_back( timestamp >> 8 );
+        out.push_back( timestamp );
+        out.push_back( length );
+        out.insert( out.end(), data, data + length );
+      }
+
+      // calls the function with the timestamp, the raw bytes and the length of every record, returns the number of records or
+      // -1 if the capture is malformed
+      template< typename Function >
+      static int for_each_record( const std::vector< uint8_t >& capture, Function&& function ) {
+        if( capture.size() < HeaderSize || capture[0] != 'B' || capture[1] != 'S' || capture[2] != 'B' || capture[3] != 'C' ||
+            capture[4] != Version ) {
+          return -1;
+        }
+
+        int    records = 0;
+        size_t pos     = HeaderSize;
+        while( pos < capture.size() ) {
+          if( pos + RecordHeaderSize > capture.size() ) {
+            return -1;
+          }
+
+          const uint32_t timestamp = uint32_t( capture[pos] ) << 24 | uint32_t( capture[pos + 1] ) << 16 |
+                                     uint32_t( capture[pos + 2] ) << 8 | capture[pos + 3];
+          const uint8_t  length    = capture[pos + 4];
+          pos += RecordHeaderSize;
+
+          if( pos + length > capture.size() ) {
+            return -1;
+          }
+
+          function( timestamp, &capture[pos], length );
+          pos += length;
+          ++records;
+        }
+
+        return records;
+      }
+
+      // feeds all records of a capture to the receiver, returns the number of records or -1 if the capture is malformed
+      static int replay( const std::vector< uint8_t >& capture, BsbPacketReceive& receive ) {
+        return for_each_record( capture, [&receive]( const uint32_t, const uint8_t* data, const uint8_t length ) {
+          for( uint8_t i = 0; i < length; ++i ) {
+            receive.loop( data[i] ^ 0xff );
+          }
+        } );
+      }
+
+      static constexpr uint8_t Version          = 1;
+      static constexpr size_t  HeaderSize       = 5;
+      static constexpr size_t  RecordHeaderSize = 5;
+    };
+  }
+}
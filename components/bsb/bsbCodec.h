@@ -0,0 +1,211 @@
+#pragma once
+
+#include <cstdint>
+#include <cstdio>
+#include <string>
+#include <vector>
+
+// The codecs describe how a value type is laid out in the payload of a telegram. They are only used as template
+// arguments, so decoding and encoding gets inlined into the entities without switching on the type at runtime.
+//
+// Every codec provides:
+//   name()         the name of the type as used in the YAML
+//   PayloadLength  the length of the payload, including the enable byte
+//   Settable       whether the value can be written with a Set telegram
+//   decode()       payload -> value, already scaled
+//   decode_raw()   payload -> the unscaled integer, for the bitfields (not the text codecs)
+//   encode_set()   value -> payload of a Set telegram
+//   encode_inf()   value -> payload of an Inf telegram
+//
+// The text codecs provide format() instead, which renders the payload as string.
+
+namespace esphome {
+  namespace bsb {
+    using BsbPayload = std::vector< uint8_t >;
+
+    struct BsbCodecBase {
+      // parameters with the enable byte 0x06 have to be sent with 0x05 to set them to zero
+      static uint8_t enable_byte_for( const uint8_t enable_byte, const bool zero ) {
+        return ( enable_byte == 0x06 && zero ) ? 0x05 : enable_byte;
+      }
+    };
+
+    // a slice of an integer value, pe one flag or sub-value of a status field; the default is the whole value
+    struct BsbBitfield {
+      uint32_t mask  = UINT32_MAX;
+      uint8_t  shift = 0;
+
+      const bool     is_set() const { return mask != UINT32_MAX || shift != 0; }
+      const uint32_t extract( const uint32_t raw ) const { return ( raw & mask ) >> shift; }
+    };
+
+    template< typename T, uint8_t Bytes, uint8_t Divider = 1 >
+    struct BsbCodecInteger : public BsbCodecBase {
+      using value_type = T;
+
+      static constexpr uint8_t PayloadLength = 1 + Bytes;
+      static constexpr bool    Settable      = true;
+
+      static bool valid( const BsbPayload& payload ) { return payload.size() == PayloadLength; }
+
+      static T decode_raw( const BsbPayload& payload ) {
+        uint32_t raw = 0;
+        for( uint8_t i = 1; i <= Bytes; ++i ) {
+          raw = raw << 8 | payload[i];
+        }
+        return T( raw );
+      }
+
+      static float decode( const BsbPayload& payload ) {
+        if( !valid( payload ) ) {
+          return 0;
+        }
+        return float( decode_raw( payload ) ) / Divider;
+      }
+
+      static T to_raw( const float value ) { return T( int64_t( value * Divider ) ); }
+
+      static void encode_raw( BsbPayload& payload, const T raw ) {
+        for( int8_t shift = ( Bytes - 1 ) * 8; shift >= 0; shift -= 8 ) {
+          payload.push_back( uint8_t( raw >> shift ) );
+        }
+      }
+
+      static void encode_set( BsbPayload& payload, const float value, const uint8_t enable_byte ) {
+        const T raw = to_raw( value );
+        payload.push_back( enable_byte_for( enable_byte, raw == 0 ) );
+        encode_raw( payload, raw );
+      }
+
+      static void encode_inf( BsbPayload& payload, const float value, const uint8_t enable_byte ) {
+        payload.push_back( enable_byte );
+        encode_raw( payload, to_raw( value ) );
+      }
+    };
+
+    struct BsbCodecUInt8 : public BsbCodecInteger< uint8_t, 1 > {
+      static const char* name() { return "UINT8"; }
+    };
+
+    struct BsbCodecInt8 : public BsbCodecInteger< int8_t, 1 > {
+      static const char* name() { return "INT8"; }
+    };
+
+    struct BsbCodecUInt16 : public BsbCodecInteger< uint16_t, 2 > {
+      static const char* name() { return "UINT16"; }
+    };
+
+    struct BsbCodecInt16 : public BsbCodecInteger< int16_t, 2 > {
+      static const char* name() { return "INT16"; }
+    };
+
+    struct BsbCodecUInt32 : public BsbCodecInteger< uint32_t, 4 > {
+      static const char* name() { return "UINT32"; }
+    };
+
+    struct BsbCodecInt32 : public BsbCodecInteger< int32_t, 4 > {
+      static const char* name() { return "INT32"; }
+    };
+
+    struct BsbCodecTemperature : public BsbCodecInteger< int16_t, 2, 64 > {
+      static const char* name() { return "TEMPERATURE"; }
+    };
+
+    // percentages in steps of 0.5%
+    struct BsbCodecPercentHalf : public BsbCodecInteger< uint8_t, 1, 2 > {
+      static const char* name() { return "PERCENT_HALF"; }
+    };
+
+    // 1 = monday ... 7 = sunday
+    struct BsbCodecWeekday : public BsbCodecInteger< uint8_t, 1 > {
+      static const char* name() { return "WEEKDAY"; }
+
+      static const char* label( const uint8_t weekday ) {
+        static const char* const labels[] = { "Monday", "Tuesday", "Wednesday", "Thursday", "Friday", "Saturday", "Sunday" };
+
+        if( weekday < 1 || weekday > 7 ) {
+          return "";
+        }
+        return labels[weekday - 1];
+      }
+
+      static std::string format( const BsbPayload& payload ) { return valid( payload ) ? label( decode_raw( payload ) ) : ""; }
+    };
+
+    // enumerations, the labels come from a BsbEnumTable
+    struct BsbCodecEnum : public BsbCodecInteger< uint8_t, 1 > {
+      static const char* name() { return "ENUM"; }
+    };
+
+    struct BsbCodecEnum16 : public BsbCodecInteger< uint16_t, 2 > {
+      static const char* name() { return "ENUM16"; }
+    };
+
+    // the room units send the room temperature without enable byte, but with a trailing zero
+    struct BsbCodecRoomTemperature : public BsbCodecBase {
+      using value_type = int16_t;
+
+      static constexpr uint8_t PayloadLength = 3;
+      static constexpr bool    Settable      = false;
+
+      static const char* name() { return "ROOMTEMPERATURE"; }
+
+      static bool valid( const BsbPayload& payload ) { return payload.size() == PayloadLength; }
+
+      static int16_t decode_raw( const BsbPayload& payload ) { return int16_t( payload[0] << 8 | payload[1] ); }
+
+      static float decode( const BsbPayload& payload ) {
+        if( !valid( payload ) ) {
+          return 0;
+        }
+        return decode_raw( payload ) / 64.f;
+      }
+
+      // the room temperature has no enable byte, the parameter is only there to match the other codecs
+      static void encode_inf( BsbPayload& payload, const float value, [[maybe_unused]] const uint8_t enable_byte ) {
+        const int16_t raw = value * 64.f;
+        payload.push_back( raw >> 8 );
+        payload.push_back( raw );
+        payload.push_back( 0 );
+      }
+
+      static void encode_set( BsbPayload& payload, const float value, const uint8_t enable_byte ) {
+        encode_inf( payload, value, enable_byte );
+      }
+    };
+
+    struct BsbCodecText : public BsbCodecBase {
+      static const char* name() { return "TEXT"; }
+
+      static std::string format( const BsbPayload& payload ) { return std::string( payload.cbegin(), payload.cend() ); }
+    };
+
+    // enable byte, year - 1900, month, day, weekday, hour, minute, second, flags
+    struct BsbCodecDateTime : public BsbCodecBase {
+      static constexpr uint8_t PayloadLength = 9;
+
+      static const char* name() { return "DATETIME"; }
+
+      static bool valid( const BsbPayload& payload ) { return payload.size() == PayloadLength; }
+
+      static std::string format( const BsbPayload& payload ) {
+        if( !valid( payload ) ) {
+          return "";
+        }
+
+        char str[24];
+        snprintf( str,
+                  sizeof( str ),
+                  "%04u-%02u-%02u %02u:%02u:%02u",
+                  1900u + payload[1],
+                  payload[2],
+                  payload[3],
+                  payload[5],
+                  payload[6],
+                  payload[7] );
+
+        return str;
+      }
+    };
+  }
+}
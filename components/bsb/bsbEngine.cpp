@@ -0,0 +1,48 @@
+#include "bsbEngine.h"
+#include "esphome/core/hal.h"
+#include "esphome/core/log.h"
+
+#include <algorithm>
+
+namespace esphome {
+  namespace bsb {
+
+    static const char* const ENGINE_TAG = "bsb.engine";
+
+    void BsbEngine::setup() {
+      ESP_LOGCONFIG( ENGINE_TAG, "Setting up BSB engine..." );
+      due_.reserve( buses_.size() );
+    }
+
+    void BsbEngine::dump_config() {
+      ESP_LOGCONFIG( ENGINE_TAG, "BSB engine:" );
+      ESP_LOGCONFIG( ENGINE_TAG, "  buses: %zu", buses_.size() );
+      ESP_LOGCONFIG( ENGINE_TAG, "  loop budget: %uus", loop_budget_ );
+    }
+
+    void BsbEngine::loop() {
+      const uint32_t start = micros();
+      const uint32_t now   = millis();
+
+      due_.clear();
+      for( BsbComponent* bus : buses_ ) {
+        const int32_t slack = bus->get_slack( now );
+        if( slack <= 0 ) {
+          // after the ones equally late, so they keep the order of the configuration
+          const auto position =
+              std::upper_bound( due_.begin(), due_.end(), slack, []( const int32_t slack, const Due& due ) { return slack < due.slack; } );
+          due_.insert( position, { bus, slack } );
+        }
+      }
+
+      for( size_t i = 0; i < due_.size(); ++i ) {
+        if( i != 0 && ( micros() - start ) >= loop_budget_ ) {
+          ++deferred_;
+          break;
+        }
+        // every bus gets the time it runs at, the ones before may have taken a while
+        due_[i].bus->run( i == 0 ? now : millis() );
+      }
+    }
+  }
+}
@@ -0,0 +1,53 @@
+#pragma once
+
+#include "bsb.h"
+#include "esphome/core/component.h"
+
+#include <cstdint>
+#include <vector>
+
+namespace esphome {
+  namespace bsb {
+    // Multi-bus mode: one engine serves the buses of all UARTs. Every bus keeps its own receive buffer, transaction
+    // timers, retries and governor, the engine only decides which bus runs when:
+    //
+    // - The main loop runs the due buses earliest deadline first: the ones with received bytes, then the ones overdue
+    //   the longest. Once the budget of the pass is spent, the rest waits for the next pass, where it is overdue the
+    //   longest and so first. At least one bus runs per pass.
+    // - The UARTs are only accessed from the main loop, like in single-bus mode; UARTComponent makes no promise for
+    //   other tasks. In between the passes, the received bytes wait in the RX buffer of the UART driver, which is filled
+    //   by its interrupt, so a long pass only needs a large enough rx_buffer_size.
+    class BsbEngine : public Component {
+    public:
+      void register_bus( BsbComponent* bus ) {
+        bus->attach_engine();
+        buses_.push_back( bus );
+      }
+
+      // the CPU time per pass of the main loop, in µs
+      void set_loop_budget( uint32_t val ) { loop_budget_ = val; }
+
+      void  setup() override;
+      void  dump_config() override;
+      void  loop() override;
+      float get_setup_priority() const override { return setup_priority::DATA - 1.0f; }
+
+      // the passes which ended with due buses left over
+      const uint32_t get_deferred() const { return deferred_; }
+
+      static constexpr uint32_t DefaultLoopBudget = 2000;
+
+    protected:
+      struct Due {
+        BsbComponent* bus;
+        int32_t       slack;
+      };
+
+      std::vector< BsbComponent* > buses_;
+      // reserved in setup(), so the passes don't allocate
+      std::vector< Due > due_;
+      uint32_t           loop_budget_ = DefaultLoopBudget;
+      uint32_t           deferred_    = 0;
+    };
+  }
+}
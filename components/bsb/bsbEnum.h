@@ -0,0 +1,56 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+
+namespace esphome {
+  namespace bsb {
+    // one entry of an enumeration, the tables get generated from the YAML sorted by value into const arrays
+    struct BsbEnumEntry {
+      uint32_t    value;
+      const char* label;
+    };
+
+    class BsbEnumTable {
+    public:
+      void set_entries( const BsbEnumEntry* entries, const size_t size ) {
+        entries_ = entries;
+        size_    = size;
+      }
+      const size_t size() const { return size_; }
+
+      // returns nullptr if the value is not in the table
+      const char* find_label( const uint32_t value ) const {
+        size_t first = 0;
+        size_t last  = size_;
+
+        while( first < last ) {
+          const size_t middle = first + ( last - first ) / 2;
+
+          if( entries_[middle].value < value ) {
+            first = middle + 1;
+          } else {
+            last = middle;
+          }
+        }
+
+        return ( first < size_ && entries_[first].value == value ) ? entries_[first].label : nullptr;
+      }
+
+      const bool find_value( const char* label, uint32_t& value ) const {
+        for( size_t i = 0; i < size_; ++i ) {
+          if( strcmp( entries_[i].label, label ) == 0 ) {
+            value = entries_[i].value;
+            return true;
+          }
+        }
+        return false;
+      }
+
+    private:
+      const BsbEnumEntry* entries_ = nullptr;
+      size_t              size_    = 0;
+    };
+  }
+}
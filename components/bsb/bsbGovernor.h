@@ -0,0 +1,123 @@
+#pragma once
+
+#include <algorithm>
+#include <cstdint>
+
+#include "bsbScheduling.h"
+
+namespace esphome {
+  namespace bsb {
+    // Load shedding: measures the utilization of the bus and the reply latency of the heating system over windows of
+    // Window ms. Under pressure, the shedding level rises by one per window, which stretches the update intervals of the
+    // background entities and then of the normal ones, so the critical ones keep their freshness. After a few relaxed
+    // windows in a row, the level drops by one again.
+    //
+    //   level  background  normal
+    //   0      1x          1x
+    //   1      4x          1x
+    //   2      8x          2x
+    //   3      16x         4x
+    class BsbLoadGovernor {
+    public:
+      void set_max_utilization( const float val ) { max_utilization_ = val; }
+
+      // every frame on the bus, including our own ones
+      void frame_received( const size_t length ) { busy_ms_ += bsb_frame_duration( length ); }
+
+      // the latency is measured for the first of the requests in flight, like the link health does
+      void request_sent( const uint32_t timestamp ) {
+        if( !pending_ ) {
+          pending_           = true;
+          pending_timestamp_ = timestamp;
+        }
+      }
+
+      void reply_received( const uint32_t timestamp ) {
+        if( pending_ ) {
+          pending_ = false;
+          latency_sum_ += timestamp - pending_timestamp_;
+          ++replies_;
+        }
+      }
+
+      void check_timeout( const uint32_t timestamp ) {
+        if( pending_ && ( timestamp - pending_timestamp_ ) >= ReplyTimeout ) {
+          pending_ = false;
+          ++lost_;
+        }
+      }
+
+      // closes the window, returns true if the shedding level changed
+      const bool evaluate( const uint32_t timestamp ) {
+        const uint32_t elapsed = std::max< uint32_t >( timestamp - window_start_, 1 );
+
+        utilization_ = std::min( float( busy_ms_ ) / elapsed, 1.0f );
+        latency_     = replies_ != 0 ? latency_sum_ / replies_ : 0;
+        loss_        = ( replies_ + lost_ ) != 0 ? float( lost_ ) / ( replies_ + lost_ ) : 0;
+
+        window_start_ = timestamp;
+        busy_ms_      = 0;
+        latency_sum_  = 0;
+        replies_      = 0;
+        lost_         = 0;
+
+        const uint8_t level = level_;
+        if( utilization_ > max_utilization_ || latency_ > HighLatency || loss_ > HighLoss ) {
+          relaxed_ = 0;
+          level_   = std::min< uint8_t >( level_ + 1, MaxLevel );
+        } else if( utilization_ < max_utilization_ / 2 && latency_ < LowLatency && loss_ == 0 ) {
+          if( level_ != 0 && ++relaxed_ >= RelaxedToRestore ) {
+            relaxed_ = 0;
+            --level_;
+          }
+        } else {
+          relaxed_ = 0;
+        }
+        return level != level_;
+      }
+
+      const uint8_t get_level() const { return level_; }
+
+      const float get_scale( const BsbPriority priority ) const {
+        switch( priority ) {
+          case BsbPriority::Background:
+            return level_ == 0 ? 1 : float( 2 << level_ );
+          case BsbPriority::Normal:
+            return level_ <= 1 ? 1 : float( 1 << ( level_ - 1 ) );
+          default:
+            return 1;
+        }
+      }
+
+      // the measurements of the last window
+      const float    get_utilization() const { return utilization_; }
+      const uint32_t get_latency() const { return latency_; }
+      const float    get_loss() const { return loss_; }
+
+      static constexpr uint32_t Window           = 10 * 1000;
+      static constexpr uint32_t ReplyTimeout     = 1000;
+      static constexpr uint32_t HighLatency      = 500;
+      static constexpr uint32_t LowLatency       = 250;
+      static constexpr float    HighLoss         = 0.2f;
+      static constexpr uint8_t  MaxLevel         = 3;
+      static constexpr uint8_t  RelaxedToRestore = 3;
+
+    private:
+      float max_utilization_ = 0.8f;
+
+      uint32_t window_start_      = 0;
+      uint32_t busy_ms_           = 0;
+      bool     pending_           = false;
+      uint32_t pending_timestamp_ = 0;
+      uint32_t latency_sum_       = 0;
+      uint32_t replies_           = 0;
+      uint32_t lost_              = 0;
+
+      float    utilization_ = 0;
+      uint32_t latency_     = 0;
+      float    loss_        = 0;
+      uint8_t  level_       = 0;
+      uint8_t  relaxed_     = 0;
+    };
+  }
+}
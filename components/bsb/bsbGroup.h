@@ -0,0 +1,176 @@
+#pragma once
+
+#include <algorithm>
+#include <cstdint>
+#include <vector>
+
+#include "bsbScheduling.h"
+#include "bsbSensor.h"
+
+namespace esphome {
+  namespace bsb {
+    // Sensors which are read back-to-back and published together, pe the values to calculate the COP from. The group
+    // has its own update interval, the intervals of the members are not used. A sweep sends the Gets of all members,
+    // each as soon as the reply to the previous one arrived, and publishes all members at once when every reply is in or
+    // the timeout passed.
+    class BsbGroup {
+    public:
+      void           set_update_interval( const uint32_t val ) { update_interval_ms_ = val; }
+      const uint32_t get_update_interval() const { return update_interval_ms_; }
+
+      void              set_priority( const BsbPriority priority ) { priority_ = priority; }
+      const BsbPriority get_priority() const { return priority_; }
+
+      // stretches the update interval, pe while nobody receives the values or under load
+      void set_interval_scale( const float val ) { interval_scale_ = val; }
+
+      void           set_timeout( const uint32_t val ) { timeout_ms_ = val; }
+      const uint32_t get_timeout() const { return timeout_ms_; }
+
+      void add_member( BsbSensorBase* sensor ) {
+        sensor->set_group( this );
+        members_.push_back( { sensor, false } );
+      }
+      const size_t size() const { return members_.size(); }
+
+      const bool is_active() const { return active_; }
+
+      // the time all values of the last sweep belong to
+      const uint32_t get_timestamp() const { return timestamp_; }
+
+      const bool is_due( const uint32_t timestamp ) const { return !active_ && get_time_until_due( timestamp ) == 0; }
+
+      // read the group ahead of the regular polls, returns false if a refresh is already requested
+      const bool request_refresh( const uint32_t timestamp ) {
+        if( refresh_requested_ ) {
+          return false;
+        }
+        refresh_requested_ = true;
+        refresh_timestamp_ = timestamp;
+        return true;
+      }
+      const bool     is_refresh_requested() const { return refresh_requested_; }
+      const uint32_t get_refresh_timestamp() const { return refresh_timestamp_; }
+
+      // sweep as soon as the priority allows, pe after a resync; unlike a refresh, nobody waits for the values
+      void make_due() { due_ = true; }
+
+      void start( const uint32_t timestamp ) {
+        active_          = true;
+        started_once_    = true;
+        due_             = false;
+        waiting_         = false;
+        next_            = 0;
+        start_timestamp_ = timestamp;
+        for( auto& member : members_ ) {
+          member.received = false;
+        }
+      }
+
+      // the next member to poll, or nullptr if all Gets of the sweep are sent
+      BsbSensorBase* next_member() {
+        // members with the same field ID are served by the same reply
+        while( next_ < members_.size() && members_[next_].received ) {
+          ++next_;
+        }
+        return next_ < members_.size() ? members_[next_].sensor : nullptr;
+      }
+
+      void member_sent( const uint32_t timestamp ) {
+        ++next_;
+        waiting_        = true;
+        sent_timestamp_ = timestamp;
+      }
+
+      // the next Get is sent when the reply arrived, or after the pacing interval if it got lost
+      const bool is_ready_to_send( const uint32_t timestamp, const uint32_t pacing ) const {
+        return !waiting_ || ( timestamp - sent_timestamp_ ) >= pacing;
+      }
+
+      // returns true if the field belongs to the running sweep
+      const bool reply_received( const uint32_t field_id ) {
+        bool member = false;
+        for( auto& item : members_ ) {
+          if( item.sensor->get_field_id() == field_id ) {
+            item.received = true;
+            member        = true;
+          }
+        }
+        if( member ) {
+          waiting_ = false;
+        }
+        return member;
+      }
+
+      const bool is_complete( const uint32_t timestamp ) const {
+        if( ( timestamp - start_timestamp_ ) >= timeout_ms_ ) {
+          return true;
+        }
+        for( const auto& member : members_ ) {
+          if( !member.received ) {
+            return false;
+          }
+        }
+        return true;
+      }
+
+      // publishes the members which got a reply, returns the number of missing ones
+      const size_t finish( const uint32_t timestamp ) {
+        active_            = false;
+        refresh_requested_ = false;
+        timestamp_         = timestamp;
+
+        size_t missing = 0;
+        for( auto& member : members_ ) {
+          if( member.received ) {
+            member.sensor->publish();
+          } else {
+            ++missing;
+          }
+        }
+        return missing;
+      }
+
+      // ms until the group has to be looked at again, the component idles until then
+      const uint32_t get_time_until_due( const uint32_t timestamp, const uint32_t pacing = 0 ) const {
+        if( active_ ) {
+          const uint32_t timeout = bsb_time_until_elapsed( timestamp, start_timestamp_, timeout_ms_ );
+          if( next_ >= members_.size() ) {
+            // all Gets are sent, only the replies are missing
+            return timeout;
+          }
+          return waiting_ ? std::min( timeout, bsb_time_until_elapsed( timestamp, sent_timestamp_, pacing ) ) : 0;
+        }
+        if( !started_once_ || due_ || refresh_requested_ ) {
+          return 0;
+        }
+        return bsb_time_until_elapsed( timestamp, start_timestamp_, bsb_scaled_interval( update_interval_ms_, interval_scale_ ) );
+      }
+
+    protected:
+      struct Member {
+        BsbSensorBase* sensor;
+        bool           received;
+      };
+
+      std::vector< Member > members_;
+
+      uint32_t update_interval_ms_ = 60 * 1000;
+      uint32_t timeout_ms_         = 5 * 1000;
+      float    interval_scale_     = 1;
+
+      BsbPriority priority_ = BsbPriority::Normal;
+
+      bool     active_            = false;
+      bool     waiting_           = false;
+      bool     started_once_      = false;
+      bool     due_               = false;
+      bool     refresh_requested_ = false;
+      size_t   next_              = 0;
+      uint32_t start_timestamp_   = 0;
+      uint32_t sent_timestamp_    = 0;
+      uint32_t refresh_timestamp_ = 0;
+      uint32_t timestamp_         = 0;
+    };
+  }
+}
@@ -0,0 +1,118 @@
+#pragma once
+
+#include <cstdint>
+
+#include "bsbScheduling.h"
+
+namespace esphome {
+  namespace bsb {
+    enum class BsbLinkState : uint8_t { Up, Degraded, Down, Recovering };
+
+    // State of the link to the heating system, driven by the replies to our Gets and Sets:
+    //   Up          replies arrive
+    //   Degraded    some replies got lost
+    //   Down        no replies at all, only a probe is sent now and then
+    //   Recovering  the first replies after Down arrived, the backlog gets polled
+    class BsbLinkHealth {
+    public:
+      const BsbLinkState get_state() const { return state_; }
+      const bool         is_down() const { return state_ == BsbLinkState::Down; }
+
+      static const char* state_name( const BsbLinkState state ) {
+        switch( state ) {
+          case BsbLinkState::Up:
+            return "up";
+          case BsbLinkState::Degraded:
+            return "degraded";
+          case BsbLinkState::Down:
+            return "down";
+          case BsbLinkState::Recovering:
+            return "recovering";
+        }
+        return "unknown";
+      }
+
+      void request_sent( const uint32_t timestamp ) {
+        if( !pending_ ) {
+          pending_           = true;
+          pending_timestamp_ = timestamp;
+        }
+      }
+
+      // the functions below return true if the state changed
+
+      const bool reply_received() {
+        pending_ = false;
+        misses_  = 0;
+
+        switch( state_ ) {
+          case BsbLinkState::Down:
+            replies_ = 0;
+            return set_state( BsbLinkState::Recovering );
+          case BsbLinkState::Recovering:
+            return ( ++replies_ >= RepliesToRecover ) && set_state( BsbLinkState::Up );
+          case BsbLinkState::Degraded:
+            return set_state( BsbLinkState::Up );
+          default:
+            return false;
+        }
+      }
+
+      const bool check_timeout( const uint32_t timestamp ) {
+        if( !pending_ || ( timestamp - pending_timestamp_ ) < ReplyTimeout ) {
+          return false;
+        }
+
+        pending_ = false;
+        ++misses_;
+
+        if( misses_ >= MissesToDown ) {
+          return set_state( BsbLinkState::Down );
+        }
+        if( misses_ >= MissesToDegraded && state_ != BsbLinkState::Down ) {
+          return set_state( BsbLinkState::Degraded );
+        }
+        return false;
+      }
+
+      const bool is_probe_due( const uint32_t timestamp ) const {
+        return is_down() && !pending_ && ( timestamp - last_probe_timestamp_ ) >= ProbeInterval;
+      }
+      void probe_sent( const uint32_t timestamp ) {
+        last_probe_timestamp_ = timestamp;
+        request_sent( timestamp );
+      }
+
+      // ms until check_timeout() or is_probe_due() can change something
+      const uint32_t get_time_until_due( const uint32_t timestamp ) const {
+        if( pending_ ) {
+          return bsb_time_until_elapsed( timestamp, pending_timestamp_, ReplyTimeout );
+        }
+        if( is_down() ) {
+          return bsb_time_until_elapsed( timestamp, last_probe_timestamp_, ProbeInterval );
+        }
+        return BsbNoDeadline;
+      }
+
+      static constexpr uint32_t ReplyTimeout     = 1000;
+      static constexpr uint32_t ProbeInterval    = 10000;
+      static constexpr uint8_t  MissesToDegraded = 2;
+      static constexpr uint8_t  MissesToDown     = 5;
+      static constexpr uint8_t  RepliesToRecover = 3;
+
+    private:
+      const bool set_state( const BsbLinkState state ) {
+        const bool changed = state_ != state;
+        state_             = state;
+        return changed;
+      }
+
+      BsbLinkState state_                = BsbLinkState::Up;
+      bool         pending_              = false;
+      uint32_t     pending_timestamp_    = 0;
+      uint32_t     last_probe_timestamp_ = 0;
+      uint8_t      misses_               = 0;
+      uint8_t      replies_              = 0;
+    };
+  }
+}
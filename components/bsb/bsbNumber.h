@@ -1,30 +1,47 @@
 #pragma once
 
+#include <cmath>
 #include <cstdint>
+#include <functional>
 
+#include "bsbEnum.h"
 #include "bsbPacket.h"
 #include "bsbPacketSend.h"
+#include "bsbScheduling.h"
 
 #include "esphome/components/number/number.h"
+#include "esphome/core/log.h"
 
 #ifdef USE_SWITCH
   #include "esphome/components/switch/switch.h"
 #endif
 
+#ifdef USE_SELECT
+  #include "esphome/components/select/select.h"
+#endif
+
 namespace esphome {
   namespace bsb {
     extern const char* const TAG;
 
-    enum NumberType { Number, Switch };
-
-    enum class BsbNumberValueType { UInt8, Int8, Int16, Int32, Temperature, RoomTemperature };
+    enum NumberType { Number, Switch, Select };
 
     class BsbNumberBase {
     public:
-      virtual NumberType get_type() = 0;
+      virtual NumberType  get_type()                  = 0;
+      virtual const char* get_value_type_name() const = 0;
+
+      virtual void set_value( const float value )    = 0;
+      virtual void decode( const BsbPacket* packet ) = 0;
+      virtual void publish()                         = 0;
 
-      virtual void set_value( const float value ) = 0;
-      virtual void publish()                      = 0;
+      // called on Ack: the written value is now confirmed by the heating system
+      virtual void set_acknowledged() = 0;
+      // called on Nack: the written value got rejected, fall back to the last confirmed value. Returns false if no value
+      // got confirmed yet, the state is kept then and the field has to be read back.
+      virtual const bool set_rejected() = 0;
+
+      virtual const BsbPacket& createPackageSet( BsbPacket& packet, uint8_t source_address, uint8_t destination_address ) = 0;
 
       void           set_field_id( const uint32_t field_id ) { this->field_id_ = field_id; }
       const uint32_t get_field_id() const { return field_id_; }
@@ -32,6 +49,15 @@ namespace esphome {
       void       set_broadcast( const bool broadcast ) { this->broadcast_ = broadcast; }
       const bool get_broadcast() const { return this->broadcast_; }
 
+      void           set_broadcast_interval( const uint32_t val ) { broadcast_interval_ms_ = val; }
+      const uint32_t get_broadcast_interval() const { return broadcast_interval_ms_; }
+
+      void           set_broadcast_min_gap( const uint32_t val ) { broadcast_min_gap_ms_ = val; }
+      const uint32_t get_broadcast_min_gap() const { return broadcast_min_gap_ms_; }
+
+      void       set_verify_after_set( const bool verify_after_set ) { this->verify_after_set_ = verify_after_set; }
+      const bool get_verify_after_set() const { return this->verify_after_set_; }
+
       void set_enable_byte( const uint8_t enable_byte ) { this->enable_byte_ = enable_byte; }
 
       void           set_update_interval( const uint32_t val ) { update_interval_ms_ = val; }
@@ -40,27 +66,34 @@ namespace esphome {
       void set_retry_interval( const uint32_t val ) { retry_interval_ms_ = val; }
       void set_retry_count( uint8_t val ) { retry_count_ = val; }
 
-      void                     set_value_type( const int type ) { this->value_type_ = ( BsbNumberValueType )type; }
-      const BsbNumberValueType get_value_type() const { return this->value_type_; }
+      void              set_priority( const BsbPriority priority ) { this->priority_ = priority; }
+      const BsbPriority get_priority() const { return this->priority_; }
+
+      // false if another entity with the same field ID polls it, the reply updates all of them
+      void       set_polled( const bool polled ) { this->polled_ = polled; }
+      const bool is_polled() const { return this->polled_; }
 
       bool is_ready_to_update( const uint32_t timestamp ) {
+        if( !polled_ || is_never_due() ) {
+          return false;
+        }
         if( sent_get_ >= 5 ) {
           ESP_LOGE( TAG, "BsbNumber Get %08X: retries exhausted, next try in %fs ", get_field_id(), retry_interval_ms_ / 1000. );
 
-          if( timestamp >= ( next_update_timestamp_ + retry_interval_ms_ ) ) {
+          if( bsb_deadline_passed( timestamp, next_update_timestamp_ + retry_interval_ms_ ) ) {
             ESP_LOGE( TAG, "BsbNumber Set %08X: retrying", get_field_id(), retry_interval_ms_ / 1000. );
             sent_get_ = 0;
             return true;
           }
         }
-        return ( sent_get_ < 5 ) && ( !broadcast_ && timestamp >= next_update_timestamp_ );
+        return ( sent_get_ < 5 ) && ( !broadcast_ && bsb_deadline_passed( timestamp, next_update_timestamp_ ) );
       }
 
       bool is_ready_to_set( const uint32_t timestamp ) {
         if( sent_set_ >= 5 ) {
           ESP_LOGE( TAG, "BsbNumber Set %08X: retries exhausted, next try in %fs ", get_field_id(), retry_interval_ms_ / 1000. );
 
-          if( timestamp >= ( next_update_timestamp_ + retry_interval_ms_ ) ) {
+          if( bsb_deadline_passed( timestamp, next_update_timestamp_ + retry_interval_ms_ ) ) {
             ESP_LOGE( TAG, "BsbNumber Set %08X: retrying", get_field_id(), retry_interval_ms_ / 1000. );
             sent_set_ = 0;
             return true;
@@ -69,88 +102,155 @@ namespace esphome {
         return ( sent_set_ < 5 ) && dirty_ /*|| ( broadcast_ && timestamp >= next_update_timestamp_ )*/;
       }
 
-      void schedule_next_regular_update( const uint32_t timestamp ) {
+      // broadcasts are sent on change, but not more often than the minimum gap, and repeated after the broadcast
+      // interval, as the heating system drops values which are not refreshed
+      bool is_ready_to_broadcast( const uint32_t timestamp ) const {
+        if( !broadcast_ ) {
+          return false;
+        }
+
+        const uint32_t since_last_broadcast = timestamp - last_broadcast_timestamp_;
+
+        if( dirty_ ) {
+          return !broadcast_sent_ || since_last_broadcast >= broadcast_min_gap_ms_;
+        }
+        return broadcast_sent_ && broadcast_interval_ms_ != 0 && since_last_broadcast >= broadcast_interval_ms_;
+      }
+
+      // ms until one of the is_ready*() functions returns true, the component idles until then
+      const uint32_t get_time_until_due( const uint32_t timestamp ) const {
+        if( broadcast_ ) {
+          if( dirty_ ) {
+            return broadcast_sent_ ? bsb_time_until_elapsed( timestamp, last_broadcast_timestamp_, broadcast_min_gap_ms_ ) : 0;
+          }
+          return ( broadcast_sent_ && broadcast_interval_ms_ != 0 )
+                 ? bsb_time_until_elapsed( timestamp, last_broadcast_timestamp_, broadcast_interval_ms_ )
+                 : BsbNoDeadline;
+        }
+
+        const uint32_t retry = bsb_time_until( timestamp, next_update_timestamp_ + retry_interval_ms_ );
+        if( dirty_ && sent_set_ < 5 ) {
+          return 0;
+        }
+        if( sent_set_ >= 5 ) {
+          return retry;
+        }
+        if( !polled_ || is_never_due() ) {
+          return BsbNoDeadline;
+        }
+        if( sent_get_ >= 5 ) {
+          return retry;
+        }
+        return bsb_time_until( timestamp, next_update_timestamp_ );
+      }
+
+      // called when the value got changed and has to be sent, so the component wakes up
+      void set_on_dirty( std::function< void() >&& callback ) { this->on_dirty_ = std::move( callback ); }
+
+      void broadcast_sent( const uint32_t timestamp ) {
+        last_broadcast_timestamp_ = timestamp;
+        broadcast_sent_           = true;
+        reset_dirty();
+      }
+
+      // the scale stretches the interval, pe while nobody receives the values
+      void schedule_next_regular_update( const uint32_t timestamp, const float scale = 1 ) {
         sent_get_              = 0;
-        next_update_timestamp_ = timestamp + update_interval_ms_;
+        last_update_timestamp_ = timestamp;
+        regular_               = true;
+        next_update_timestamp_ = timestamp + bsb_scaled_interval( update_interval_ms_, scale );
       }
       void schedule_next_update( const uint32_t timestamp, const uint32_t interval ) {
         sent_get_              = 0;
+        regular_               = false;
         next_update_timestamp_ = timestamp + interval;
       }
 
+      // a new scale for the pending regular update, as if it had been scheduled with it, see BsbSensorBase
+      void reschedule( const float scale ) {
+        if( regular_ && sent_get_ == 0 ) {
+          next_update_timestamp_ = last_update_timestamp_ + bsb_scaled_interval( update_interval_ms_, scale );
+        }
+      }
+
+      // poll and set as soon as possible, pe after the link to the heating system recovered
+      void reset_retries( const uint32_t timestamp ) {
+        sent_get_              = 0;
+        sent_set_              = 0;
+        regular_               = false;
+        next_update_timestamp_ = timestamp;
+      }
+
       void reset_dirty() {
         sent_set_ = 0;
         dirty_    = false;
       }
 
-      const BsbPacket createPackageSet( uint8_t source_address, uint8_t destination_address ) {
-        ++sent_set_;
+      // the telegrams are built into the packet of the component, see bsb_build_get()
+      const BsbPacket& createPackageGet( BsbPacket& packet, uint8_t source_address, uint8_t destination_address ) {
+        ++sent_get_;
 
-        switch( get_value_type() ) {
-          case BsbNumberValueType::UInt8: {
-            return BsbPacketSetUInt8(
-              source_address, destination_address, get_field_id(), ( uint8_t )( getValueToSendUint32() ), enable_byte_ );
-          } break;
-          case BsbNumberValueType::Int8: {
-            return BsbPacketSetInt8(
-              source_address, destination_address, get_field_id(), ( int8_t )( getValueToSendUint32() ), enable_byte_ );
-          } break;
-
-          case BsbNumberValueType::Int16: {
-            return BsbPacketSetInt16(
-              source_address, destination_address, get_field_id(), ( int16_t )( getValueToSendUint32() ), enable_byte_ );
-          } break;
-
-          case BsbNumberValueType::Int32: {
-            return BsbPacketSetInt32(
-              source_address, destination_address, get_field_id(), ( int32_t )( getValueToSendUint32() ), enable_byte_ );
-          } break;
-
-          case BsbNumberValueType::Temperature: {
-            if( broadcast_ ) {
-              return BsbPacketInfTemperature( source_address, get_field_id(), getValueToSendFloat(), enable_byte_ );
-            } else {
-              return BsbPacketSetTemperature( source_address, destination_address, get_field_id(), getValueToSendFloat(), enable_byte_ );
-            }
-          }
-          case BsbNumberValueType::RoomTemperature: {
-            if( broadcast_ ) {
-              return BsbPacketInfRoomTemperature( source_address, get_field_id(), getValueToSendFloat(), enable_byte_ );
-            } else {
-              return BsbPacket();
-            }
-          } break;
+        return bsb_build_get( packet, source_address, destination_address, get_field_id() );
+      }
 
-          default:
-            return BsbPacket();
+    protected:
+      template< typename Codec >
+      const BsbPacket& create_package_set( BsbPacket& packet, uint8_t source_address, uint8_t destination_address ) {
+        ++sent_set_;
+
+        if( broadcast_ ) {
+          return bsb_build_inf< Codec >( packet, source_address, get_field_id(), getValueToSendFloat(), enable_byte_ );
+        }
+        if( Codec::Settable ) {
+          return bsb_build_set< Codec >( packet, source_address, destination_address, get_field_id(), getValueToSendFloat(), enable_byte_ );
         }
+        // an empty packet isn't sent
+        packet.buffer.clear();
+        return packet;
       }
 
-      const BsbPacket createPackageGet( uint8_t source_address, uint8_t destination_address ) {
-        ++sent_get_;
-
-        return BsbPacketGet( source_address, destination_address, get_field_id() );
+      void mark_dirty() {
+        dirty_ = true;
+        if( on_dirty_ ) {
+          on_dirty_();
+        }
       }
 
-    protected:
       virtual const uint32_t getValueToSendUint32() const = 0;
       virtual const float    getValueToSendFloat() const  = 0;
 
       // uint16_t           parameterNumber_ = 0;
-      uint32_t           field_id_    = 0;
-      uint8_t            enable_byte_ = 0x01;
-      bool               broadcast_   = false;
-      BsbNumberValueType value_type_  = BsbNumberValueType::Temperature;
+      uint32_t field_id_    = 0;
+      uint8_t  enable_byte_ = 0x01;
+      bool     broadcast_   = false;
+      bool     polled_      = true;
+
+      BsbPriority priority_ = BsbPriority::Normal;
+
+      // read back the value after a Set, for parameters which get clamped or changed by the heating system
+      bool verify_after_set_ = true;
 
       uint32_t update_interval_ms_;
       uint32_t retry_interval_ms_;
       uint8_t  retry_count_;
 
       uint32_t next_update_timestamp_ = 0;
+      uint32_t last_update_timestamp_ = 0;
+      bool     regular_               = false;
+
+      // read with an update_interval of never, until a Set or a reset asks for the value again
+      const bool is_never_due() const { return regular_ && update_interval_ms_ == BsbNever; }
+
+      uint32_t broadcast_interval_ms_    = 0;
+      uint32_t broadcast_min_gap_ms_     = 1000;
+      uint32_t last_broadcast_timestamp_ = 0;
+      bool     broadcast_sent_           = false;
 
       uint16_t sent_set_ = 0;
       uint16_t sent_get_ = 0;
       bool     dirty_    = false;
+
+      std::function< void() > on_dirty_;
     };
 
     class BsbNumber
@@ -161,13 +261,28 @@ namespace esphome {
 
       virtual void control( float value ) override {
         this->state = value;
-        dirty_      = true;
+        mark_dirty();
       }
 
-      void set_value( const float value ) override { publish_state( value * factor_ / divisor_ ); }
+      void set_value( const float value ) override {
+        confirmed_value_ = value * factor_ / divisor_;
+        publish_state( confirmed_value_ );
+      }
 
       void publish() override { publish_state( state ); }
 
+      void set_acknowledged() override {
+        confirmed_value_ = state;
+        publish();
+      }
+      const bool set_rejected() override {
+        if( std::isnan( confirmed_value_ ) ) {
+          return false;
+        }
+        publish_state( confirmed_value_ );
+        return true;
+      }
+
       void        set_divisor( const float divisor ) { this->divisor_ = divisor; }
       const float get_divisor() const { return this->divisor_; }
 
@@ -178,9 +293,21 @@ namespace esphome {
       const uint32_t getValueToSendUint32() const override { return getValueToSendFloat(); }
       const float    getValueToSendFloat() const override { return state * divisor_ / factor_; }
 
-      bool  broadcast_ = false;
-      float divisor_   = 1.;
-      float factor_    = 1.;
+      bool  broadcast_       = false;
+      float divisor_         = 1.;
+      float factor_          = 1.;
+      float confirmed_value_ = NAN;
+    };
+
+    template< typename Codec >
+    class BsbNumberTyped : public BsbNumber {
+    public:
+      const char* get_value_type_name() const override { return Codec::name(); }
+      void        decode( const BsbPacket* packet ) override { set_value( Codec::decode( packet->payload ) ); }
+
+      const BsbPacket& createPackageSet( BsbPacket& packet, uint8_t source_address, uint8_t destination_address ) override {
+        return create_package_set< Codec >( packet, source_address, destination_address );
+      }
     };
 
 #ifdef USE_SWITCH
@@ -197,9 +324,9 @@ namespace esphome {
         //   publish_state( true );
         // } else {
         if( value == off_value_ ) {
-          publish_state( false );
+          set_value( false );
         } else {
-          publish_state( true );
+          set_value( true );
           // uint32_t val = value;
           // ESP_LOGE( TAG, "Switch %08X: unknown value: %X|%f", get_field_id(), val, value );
           // }
@@ -214,10 +341,27 @@ namespace esphome {
 
       virtual void write_state( bool value ) override {
         this->state = value;
-        dirty_      = true;
+        mark_dirty();
+      }
+
+      void set_value( const bool value ) {
+        confirmed_state_ = value;
+        confirmed_       = true;
+        publish_state( value );
       }
 
-      void set_value( const bool value ) { publish_state( value ); }
+      void set_acknowledged() override {
+        confirmed_state_ = state;
+        confirmed_       = true;
+        publish();
+      }
+      const bool set_rejected() override {
+        if( !confirmed_ ) {
+          return false;
+        }
+        publish_state( confirmed_state_ );
+        return true;
+      }
 
     protected:
       const uint32_t getValueToSendUint32() const override { return state ? on_value_ : off_value_; }
@@ -225,6 +369,94 @@ namespace esphome {
 
       float on_value_;
       float off_value_;
+      bool  confirmed_state_ = false;
+      bool  confirmed_       = false;
+    };
+
+    template< typename Codec >
+    class BsbSwitchTyped : public BsbSwitch {
+    public:
+      const char* get_value_type_name() const override { return Codec::name(); }
+      void        decode( const BsbPacket* packet ) override { set_value( Codec::decode( packet->payload ) ); }
+
+      const BsbPacket& createPackageSet( BsbPacket& packet, uint8_t source_address, uint8_t destination_address ) override {
+        return create_package_set< Codec >( packet, source_address, destination_address );
+      }
+    };
+#endif
+
+#ifdef USE_SELECT
+    class BsbSelect
+        : public BsbNumberBase
+        , public select::Select {
+    public:
+      NumberType get_type() override { return NumberType::Select; }
+
+      void set_enum_table( const BsbEnumEntry* entries, const size_t size ) { table_.set_entries( entries, size ); }
+
+      void publish() override { publish_value( value_ ); }
+
+      void set_value( const float value ) override {
+        value_           = value;
+        confirmed_value_ = value_;
+        confirmed_       = true;
+        publish();
+      }
+
+      void set_acknowledged() override {
+        confirmed_value_ = value_;
+        confirmed_       = true;
+        publish();
+      }
+      const bool set_rejected() override {
+        if( !confirmed_ ) {
+          return false;
+        }
+        value_ = confirmed_value_;
+        publish();
+        return true;
+      }
+
+    protected:
+      void control( const std::string& value ) override {
+        uint32_t raw;
+        if( table_.find_value( value.c_str(), raw ) ) {
+          value_ = raw;
+          mark_dirty();
+        }
+      }
+
+      void publish_value( const uint32_t value ) {
+        const char* label = table_.find_label( value );
+        if( label != nullptr ) {
+          publish_state( label );
+        } else {
+          ESP_LOGW( TAG, "Select %08X: unknown value %u", get_field_id(), value );
+        }
+      }
+
+      const uint32_t getValueToSendUint32() const override { return value_; }
+      const float    getValueToSendFloat() const override { return value_; }
+
+      BsbEnumTable table_;
+      uint32_t     value_           = 0;
+      uint32_t     confirmed_value_ = 0;
+      bool         confirmed_       = false;
+    };
+
+    template< typename Codec >
+    class BsbSelectTyped : public BsbSelect {
+    public:
+      const char* get_value_type_name() const override { return Codec::name(); }
+      void        decode( const BsbPacket* packet ) override {
+        if( Codec::valid( packet->payload ) ) {
+          set_value( Codec::decode_raw( packet->payload ) );
+        }
+      }
+
+      const BsbPacket& createPackageSet( BsbPacket& packet, uint8_t source_address, uint8_t destination_address ) override {
+        return create_package_set< Codec >( packet, source_address, destination_address );
+      }
     };
 #endif
 
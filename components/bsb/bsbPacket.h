@@ -3,13 +3,15 @@
 
 #include <algorithm>
 #include <cstdint>
+#include <cstdio>
 #include <functional>
 #include <string>
 #include <vector>
 
-#include "esphome/core/helpers.h"
-
 // BsbPacket and derived classes work with already flipped data!
+//
+// The protocol core (bsbPacket*.h, bsbCodec.h, bsbCapture.h) only uses the standard library, so it can be built and
+// profiled on the host without ESPHome.
 
 namespace esphome {
   namespace bsb {
@@ -42,88 +44,85 @@ namespace esphome {
         return crc;
       }
 
-      std::string print_packet() const {
-        std::string output;
-        output = "BSB Packet: ";
-
-        char str[100];
+      // formats the packet into the buffer of PrintSize, so the log of every telegram doesn't allocate
+      const char* print_packet( char* output, const size_t size ) const {
+        char        unknown[12];
+        const char* command_name = unknown;
+        size_t      length       = 0;
 
         switch( command ) {
           case Command::Inf:
-            output += "Inf";
+            command_name = "Inf";
             break;
           case Command::Set:
-            output += "Set";
+            command_name = "Set";
             break;
           case Command::Ack:
-            output += "Ack";
+            command_name = "Ack";
             break;
           case Command::Nack:
-            output += "Nack";
+            command_name = "Nack";
             break;
           case Command::Get:
-            output += "Get";
+            command_name = "Get";
             break;
           case Command::Ret:
-            output += "Ret";
+            command_name = "Ret";
             break;
           default:
-            snprintf( str, 100, "UNK (%02hhX)", ( uint8_t )command );
-            output += str;
+            snprintf( unknown, sizeof( unknown ), "UNK (%02hhX)", ( uint8_t )command );
             break;
         }
 
-        snprintf( str, 100, " %02hhX->%02hhX, len: %2hhu", sourceAddress, destinationAddress, lenght );
-        output += str;
-
-        snprintf( str, 100, ", field: %08X, CRC: %04hX", fieldId, crc );
-        output += str;
+        length += append( output + length,
+                          size - length,
+                          "BSB Packet: %s %02hhX->%02hhX, len: %2hhu, field: %08X, CRC: %04hX",
+                          command_name,
+                          sourceAddress,
+                          destinationAddress,
+                          lenght,
+                          fieldId,
+                          crc );
 
         if( payload.size() ) {
-          output += ", payload: ";
-          output += format_hex_pretty( payload );
+          length += append( output + length, size - length, ", payload: " );
+          length += format_hex( output + length, size - length, payload );
         }
 
-        output += " (";
-        output += esphome::format_hex_pretty( buffer );
-        output += ") ";
+        length += append( output + length, size - length, " (" );
+        length += format_hex( output + length, size - length, buffer );
+        append( output + length, size - length, ") " );
 
         return output;
       }
 
-      int8_t parse_as_int8() const {
-        if( payload.size() != 2 ) {
-          return 0;
-        }
-
-        return payload.back();
-      }
-
-      uint8_t parse_as_uint8() const {
-        if( payload.size() != 2 ) {
-          return 0;
+      // same format as format_hex_pretty() of ESPHome: "DC.C2.00 (3)"; returns the number of characters written
+      static const size_t format_hex( char* output, const size_t size, const std::vector< uint8_t >& data ) {
+        if( data.empty() ) {
+          return append( output, size, "" );
         }
 
-        return payload.back();
-      }
+        static const char* const digits = "0123456789ABCDEF";
 
-      int16_t parse_as_int16() const {
-        if( payload.size() != 3 ) {
-          return 0;
+        size_t length = 0;
+        for( const uint8_t b : data ) {
+          // the separator, two digits and the terminator
+          if( length + 4 > size ) {
+            return length;
+          }
+          if( length != 0 ) {
+            output[length++] = '.';
+          }
+          output[length++] = digits[b >> 4];
+          output[length++] = digits[b & 0x0F];
         }
+        output[length] = '\0';
 
-        return payload[1] << 8 | payload[2];
+        return length + append( output + length, size - length, " (%u)", unsigned( data.size() ) );
       }
 
-      float parse_as_temperature() const { return parse_as_int16() / 64.; }
-
-      int32_t parse_as_int32() const {
-        if( payload.size() != 5 ) {
-          return 0;
-        }
-
-        return payload[1] << 24 | payload[2] << 16 | payload[3] << 8 | payload[4];
-      }
+      // fits the longest telegram in print_packet()
+      static constexpr size_t PrintSize = 256;
 
       std::string parse_as_text() const { return std::string( payload.cbegin(), payload.cend() ); }
 
@@ -209,6 +208,17 @@ namespace esphome {
       uint16_t               crc;
 
       static constexpr uint8_t PacketSizeWithoutPyload = 11;
+
+    protected:
+      // snprintf() which returns the number of characters written, also if the output got truncated
+      template< typename... Args >
+      static const size_t append( char* output, const size_t size, const char* format, const Args... args ) {
+        if( size == 0 ) {
+          return 0;
+        }
+        const int length = snprintf( output, size, format, args... );
+        return length < 0 ? 0 : std::min( size_t( length ), size - 1 );
+      }
     };
   }
 }
@@ -8,8 +8,6 @@
 #include <string>
 #include <vector>
 
-#include "esphome/core/helpers.h"
-
 #include "bsbPacket.h"
 
 namespace esphome {
@@ -120,7 +118,10 @@ namespace esphome {
             uint16_t crcCalculated = CRC( buffer.cbegin(), buffer.cend() - 2 );
 
             if( crc == crcCalculated ) {
+              ++frames;
               callback( this );
+            } else {
+              ++crcErrors;
             }
 
             state = ProtocolStates::Start;
@@ -128,9 +129,17 @@ namespace esphome {
         }
       }
 
+      // frames passed to the callback
+      const uint32_t get_frames() const { return frames; }
+      // frames dropped because of a wrong CRC, pe after a collision
+      const uint32_t get_crc_errors() const { return crcErrors; }
+
     private:
       std::function< void( const BsbPacket* ) > callback;
 
+      uint32_t frames    = 0;
+      uint32_t crcErrors = 0;
+
       ProtocolStates state = ProtocolStates::Start;
     };
   }
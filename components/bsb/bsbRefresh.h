@@ -0,0 +1,92 @@
+#pragma once
+
+#include <algorithm>
+#include <cstdint>
+#include <vector>
+
+#include "bsbScheduling.h"
+
+namespace esphome {
+  namespace bsb {
+    // Fields to read as soon as possible, ahead of the regular polls. Every field is queued only once, repeated
+    // requests are merged until its reply arrived or the reply timeout passed.
+    class BsbRefreshQueue {
+    public:
+      struct Refresh {
+        uint32_t field_id;
+        uint32_t requested_timestamp;
+        uint32_t sent_timestamp;
+        bool     sent;
+      };
+
+      BsbRefreshQueue() { refreshes_.reserve( 8 ); }
+
+      // returns false if the field is already queued
+      const bool request( const uint32_t field_id, const uint32_t timestamp ) {
+        if( find( field_id ) != refreshes_.end() ) {
+          return false;
+        }
+        refreshes_.push_back( { field_id, timestamp, 0, false } );
+        return true;
+      }
+
+      // the next refresh to send, or nullptr
+      Refresh* next() {
+        for( auto& refresh : refreshes_ ) {
+          if( !refresh.sent ) {
+            return &refresh;
+          }
+        }
+        return nullptr;
+      }
+
+      void sent( Refresh* refresh, const uint32_t timestamp ) {
+        refresh->sent           = true;
+        refresh->sent_timestamp = timestamp;
+      }
+
+      // returns true if the field got refreshed, with the time from the request to the reply
+      const bool reply_received( const uint32_t field_id, const uint32_t timestamp, uint32_t& latency ) {
+        auto it = find( field_id );
+        if( it == refreshes_.end() || !it->sent ) {
+          return false;
+        }
+        latency = timestamp - it->requested_timestamp;
+        refreshes_.erase( it );
+        return true;
+      }
+
+      // drops the refreshes which didn't get a reply
+      void expire( const uint32_t timestamp ) {
+        refreshes_.erase( std::remove_if( refreshes_.begin(),
+                                          refreshes_.end(),
+                                          [timestamp]( const Refresh& refresh ) {
+                                            return refresh.sent && ( timestamp - refresh.sent_timestamp ) >= Timeout;
+                                          } ),
+                          refreshes_.end() );
+      }
+
+      const size_t size() const { return refreshes_.size(); }
+
+      // ms until a refresh has to be sent or expires, the component idles until then
+      const uint32_t get_time_until_due( const uint32_t timestamp ) const {
+        uint32_t idle = BsbNoDeadline;
+        for( const auto& refresh : refreshes_ ) {
+          idle = std::min( idle, refresh.sent ? bsb_time_until_elapsed( timestamp, refresh.sent_timestamp, Timeout ) : 0 );
+        }
+        return idle;
+      }
+
+      static constexpr uint32_t Timeout = 1000;
+
+    protected:
+      std::vector< Refresh >::iterator find( const uint32_t field_id ) {
+        return std::find_if( refreshes_.begin(), refreshes_.end(), [field_id]( const Refresh& refresh ) {
+          return refresh.field_id == field_id;
+        } );
+      }
+
+      std::vector< Refresh > refreshes_;
+    };
+  }
+}
@@ -0,0 +1,97 @@
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+
+namespace esphome {
+  namespace bsb {
+    // no deadline at all, pe a broadcast without repetition
+    static constexpr uint32_t BsbNoDeadline = UINT32_MAX;
+
+    // true if the deadline passed; compares the difference, so it stays right when millis() overflows after 49.7 days
+    inline const bool bsb_deadline_passed( const uint32_t timestamp, const uint32_t deadline ) {
+      return int32_t( timestamp - deadline ) >= 0;
+    }
+
+    // ms until the deadline, 0 if it already passed; compares the same way as bsb_deadline_passed()
+    inline const uint32_t bsb_time_until( const uint32_t timestamp, const uint32_t deadline ) {
+      return bsb_deadline_passed( timestamp, deadline ) ? 0 : deadline - timestamp;
+    }
+
+    // an update_interval of never, SCHEDULER_DONT_RUN in ESPHome: the field is read at the start, after a resync and on
+    // request, but never again on its own
+    static constexpr uint32_t BsbNever = UINT32_MAX;
+
+    // the longest interval the deadlines can express
+    static constexpr uint32_t BsbMaxInterval = INT32_MAX;
+
+    // never stays never, the other intervals are capped at what the deadlines can express
+    inline const uint32_t bsb_scaled_interval( const uint32_t interval, const float scale ) {
+      if( interval == BsbNever ) {
+        return BsbNever;
+      }
+      if( scale == 1 ) {
+        return std::min( interval, BsbMaxInterval );
+      }
+      const float scaled = interval * scale;
+      return scaled >= float( BsbMaxInterval ) ? BsbMaxInterval : uint32_t( scaled );
+    }
+
+    // ms until an interval since the start passed, safe for the overflow of millis()
+    inline const uint32_t bsb_time_until_elapsed( const uint32_t timestamp, const uint32_t start, const uint32_t interval ) {
+      const uint32_t elapsed = timestamp - start;
+      return elapsed < interval ? interval - elapsed : 0;
+    }
+
+    // ms a frame occupies the bus: 4800 baud with 8 data bits, parity and a stop bit, rounded up
+    inline const uint32_t bsb_frame_duration( const size_t length ) { return ( length * 11 * 1000 + 4799 ) / 4800; }
+
+    // under load, the update intervals of the entities are stretched by their priority, see bsbGovernor.h
+    enum class BsbPriority : uint8_t { Critical, Normal, Background };
+
+    inline const char* bsb_priority_name( const BsbPriority priority ) {
+      switch( priority ) {
+        case BsbPriority::Critical:
+          return "critical";
+        case BsbPriority::Normal:
+          return "normal";
+        case BsbPriority::Background:
+          return "background";
+      }
+      return "unknown";
+    }
+
+    // CPU time spent in loop(), summed up over a window of a minute and normalized to a second
+    class BsbLoopLoad {
+    public:
+      void begin( const uint32_t timestamp_us ) { begin_us_ = timestamp_us; }
+
+      // returns true if a window is complete, the result is in get_busy_per_second()
+      const bool end( const uint32_t timestamp_us, const uint32_t timestamp_ms ) {
+        busy_us_ += timestamp_us - begin_us_;
+
+        const uint32_t elapsed = timestamp_ms - window_start_ms_;
+        if( elapsed < Window ) {
+          return false;
+        }
+
+        busy_per_second_ = float( busy_us_ ) / 1000.0f * 1000.0f / elapsed;
+        busy_us_         = 0;
+        window_start_ms_ = timestamp_ms;
+        return true;
+      }
+
+      // ms of CPU time per second
+      const float get_busy_per_second() const { return busy_per_second_; }
+
+      static constexpr uint32_t Window = 60 * 1000;
+
+    private:
+      uint32_t begin_us_        = 0;
+      uint32_t busy_us_         = 0;
+      uint32_t window_start_ms_ = 0;
+      float    busy_per_second_ = 0;
+    };
+  }
+}
@@ -1,8 +1,14 @@
 #pragma once
 
+#include "bsbAggregate.h"
+#include "bsbCodec.h"
+#include "bsbEnum.h"
 #include "bsbPacketSend.h"
+#include "bsbScheduling.h"
 
 #include "esphome/components/sensor/sensor.h"
+#include "esphome/core/hal.h"
+#include "esphome/core/log.h"
 
 #ifdef USE_BINARY_SENSOR
   #include "esphome/components/binary_sensor/binary_sensor.h"
@@ -14,15 +20,18 @@
 
 namespace esphome {
   namespace bsb {
+    extern const char* const TAG;
 
     enum SensorType { Sensor, TextSensor, BinarySensor };
 
-    enum class BsbSensorValueType { UInt8, Int8, Int16, Int32, Temperature, RoomTemperature };
+    class BsbGroup;
 
     class BsbSensorBase {
     public:
-      virtual SensorType get_type() = 0;
-      virtual void       publish()  = 0;
+      virtual SensorType  get_type()                        = 0;
+      virtual const char* get_value_type_name() const       = 0;
+      virtual void        decode( const BsbPacket* packet ) = 0;
+      virtual void        publish()                         = 0;
 
       void           set_field_id( const uint32_t field_id ) { this->field_id_ = field_id; }
       const uint32_t get_field_id() const { return field_id_; }
@@ -33,44 +42,97 @@ namespace esphome {
       void set_retry_interval( const uint32_t retry_interval_ms ) { retry_interval_ms_ = retry_interval_ms; }
       void set_retry_count( uint8_t retry_count ) { retry_count_ = retry_count; }
 
-      void                     set_value_type( const int value_type ) { this->value_type_ = ( BsbSensorValueType )value_type; }
-      const BsbSensorValueType get_value_type() const { return this->value_type_; }
+      // members of a group are polled by the group instead of their own update interval, see bsbGroup.h
+      void      set_group( BsbGroup* group ) { this->group_ = group; }
+      BsbGroup* get_group() const { return this->group_; }
+
+      void              set_priority( const BsbPriority priority ) { this->priority_ = priority; }
+      const BsbPriority get_priority() const { return this->priority_; }
+
+      // decode only a slice of the value, so several entities can share the Get of a status field
+      void set_bitfield( const uint32_t mask, const uint8_t shift ) {
+        bitfield_.mask  = mask;
+        bitfield_.shift = shift;
+      }
+      const BsbBitfield& get_bitfield() const { return bitfield_; }
+
+      // false if another entity with the same field ID polls it, the reply updates all of them
+      void       set_polled( const bool polled ) { this->polled_ = polled; }
+      const bool is_polled() const { return this->polled_; }
 
       const bool is_ready( const uint32_t timestamp ) {
+        if( !polled_ || is_never_due() ) {
+          return false;
+        }
         if( sent_get_ >= 5 ) {
           ESP_LOGE( TAG, "BsbNumber Get %08X: retries exhausted, next try in %fs ", get_field_id(), retry_interval_ms_ / 1000. );
-          if( timestamp >= ( next_update_timestamp_ + retry_interval_ms_ ) ) {
+          if( bsb_deadline_passed( timestamp, next_update_timestamp_ + retry_interval_ms_ ) ) {
             ESP_LOGE( TAG, "BsbNumber Set %08X: retrying", get_field_id(), retry_interval_ms_ / 1000. );
             sent_get_ = 0;
             return true;
           }
         }
 
-        return ( sent_get_ < 5 ) && ( timestamp >= next_update_timestamp_ );
+        return ( sent_get_ < 5 ) && bsb_deadline_passed( timestamp, next_update_timestamp_ );
+      }
+
+      // ms until is_ready() returns true, the component idles until then
+      const uint32_t get_time_until_due( const uint32_t timestamp ) const {
+        if( !polled_ || is_never_due() ) {
+          return BsbNoDeadline;
+        }
+        return bsb_time_until( timestamp, sent_get_ >= 5 ? next_update_timestamp_ + retry_interval_ms_ : next_update_timestamp_ );
       }
 
-      void schedule_next_regular_update( const uint32_t timestamp ) {
+      // the scale stretches the interval, pe while nobody receives the values
+      void schedule_next_regular_update( const uint32_t timestamp, const float scale = 1 ) {
         sent_get_              = 0;
-        next_update_timestamp_ = timestamp + update_interval_ms_;
+        last_update_timestamp_ = timestamp;
+        regular_               = true;
+        next_update_timestamp_ = timestamp + bsb_scaled_interval( update_interval_ms_, scale );
       }
 
-      const BsbPacket createPackageGet( uint8_t source_address, uint8_t destination_address ) {
+      // a new scale for the pending regular update, as if it had been scheduled with it, pe when the load shedding
+      // changes its level; a due or retried update stays as it is
+      void reschedule( const float scale ) {
+        if( regular_ && sent_get_ == 0 ) {
+          next_update_timestamp_ = last_update_timestamp_ + bsb_scaled_interval( update_interval_ms_, scale );
+        }
+      }
+
+      // poll as soon as possible, pe after the link to the heating system recovered
+      void reset_retries( const uint32_t timestamp ) {
+        sent_get_              = 0;
+        regular_               = false;
+        next_update_timestamp_ = timestamp;
+      }
+
+      // the telegram is built into the packet of the component, see bsb_build_get()
+      const BsbPacket& createPackageGet( BsbPacket& packet, uint8_t source_address, uint8_t destination_address ) {
         ++sent_get_;
 
-        return BsbPacketGet( source_address, destination_address, get_field_id() );
+        return bsb_build_get( packet, source_address, destination_address, get_field_id() );
       }
 
     protected:
-      uint32_t           field_id_;
-      BsbSensorValueType value_type_ = BsbSensorValueType::Temperature;
+      uint32_t    field_id_;
+      BsbGroup*   group_  = nullptr;
+      bool        polled_ = true;
+      BsbBitfield bitfield_;
+      BsbPriority priority_ = BsbPriority::Normal;
 
       uint32_t update_interval_ms_;
       uint32_t retry_interval_ms_;
       uint8_t  retry_count_;
 
     private:
+      // read with an update_interval of never, until a reset asks for the value again
+      const bool is_never_due() const { return regular_ && update_interval_ms_ == BsbNever; }
+
       uint32_t next_update_timestamp_ = 0;
+      uint32_t last_update_timestamp_ = 0;
       uint16_t sent_get_              = 0;
+      bool     regular_               = false;
     };
 
     class BsbSensor
@@ -78,7 +140,36 @@ namespace esphome {
         , public sensor::Sensor {
     public:
       SensorType get_type() override { return SensorType::Sensor; }
-      void       publish() override { publish_state( value_ ); }
+
+      void publish() override {
+        if( aggregate_window_ms_ == 0 ) {
+          publish_state( value_ );
+          return;
+        }
+
+        // sample at the update interval, but only publish once per window. If the samples arrive faster than the ring
+        // was sized for, pe with the INF telegrams of the heating system, the window is closed early instead of losing
+        // its first samples.
+        const uint32_t now = millis();
+        if( samples_.empty() ) {
+          window_start_timestamp_ = now;
+        }
+        samples_.push( value_ );
+
+        if( samples_.full() || ( now - window_start_timestamp_ ) >= aggregate_window_ms_ ) {
+          publish_aggregate();
+        }
+      }
+
+      void set_aggregate( const uint32_t window_ms, const uint8_t capacity ) {
+        aggregate_window_ms_ = window_ms;
+        samples_.set_capacity( capacity );
+      }
+      const uint32_t get_aggregate_window() const { return aggregate_window_ms_; }
+
+      void set_min_sensor( sensor::Sensor* min_sensor ) { this->min_sensor_ = min_sensor; }
+      void set_max_sensor( sensor::Sensor* max_sensor ) { this->max_sensor_ = max_sensor; }
+      void set_mean_sensor( sensor::Sensor* mean_sensor ) { this->mean_sensor_ = mean_sensor; }
 
       void set_enable_byte( const uint8_t enable_byte ) { this->enable_byte_ = enable_byte; }
 
@@ -91,11 +182,46 @@ namespace esphome {
       const float get_factor() const { return this->factor_; }
 
     protected:
+      void publish_aggregate() {
+        if( min_sensor_ != nullptr ) {
+          min_sensor_->publish_state( samples_.min() );
+        }
+        if( max_sensor_ != nullptr ) {
+          max_sensor_->publish_state( samples_.max() );
+        }
+        if( mean_sensor_ != nullptr ) {
+          mean_sensor_->publish_state( samples_.mean() );
+        }
+        publish_state( samples_.last() );
+
+        samples_.clear();
+      }
+
       float   divisor_     = 1.;
       float   factor_      = 1.;
       uint8_t enable_byte_ = 0x01;
 
       float value_;
+
+      uint32_t        aggregate_window_ms_    = 0;
+      uint32_t        window_start_timestamp_ = 0;
+      BsbSampleRing   samples_;
+      sensor::Sensor* min_sensor_  = nullptr;
+      sensor::Sensor* max_sensor_  = nullptr;
+      sensor::Sensor* mean_sensor_ = nullptr;
+    };
+
+    template< typename Codec >
+    class BsbSensorTyped : public BsbSensor {
+    public:
+      const char* get_value_type_name() const override { return Codec::name(); }
+      void        decode( const BsbPacket* packet ) override {
+        if( !bitfield_.is_set() ) {
+          set_value( Codec::decode( packet->payload ) );
+          return;
+        }
+        set_value( Codec::valid( packet->payload ) ? bitfield_.extract( uint32_t( Codec::decode_raw( packet->payload ) ) ) : 0 );
+      }
     };
 
 #ifdef USE_TEXT_SENSOR
@@ -111,6 +237,48 @@ namespace esphome {
     protected:
       std::string value_;
     };
+
+    template< typename Codec >
+    class BsbTextSensorTyped : public BsbTextSensor {
+    public:
+      const char* get_value_type_name() const override { return Codec::name(); }
+      void        decode( const BsbPacket* packet ) override { set_value( Codec::format( packet->payload ) ); }
+    };
+
+    // publishes the label of the value from a table in flash, without building a string for every update
+    template< typename Codec >
+    class BsbEnumTextSensor : public BsbTextSensor {
+    public:
+      const char* get_value_type_name() const override { return Codec::name(); }
+
+      void set_enum_table( const BsbEnumEntry* entries, const size_t size ) { table_.set_entries( entries, size ); }
+
+      void decode( const BsbPacket* packet ) override {
+        if( !Codec::valid( packet->payload ) ) {
+          label_ = nullptr;
+          return;
+        }
+
+        const uint32_t value = bitfield_.extract( Codec::decode_raw( packet->payload ) );
+        label_               = table_.find_label( value );
+
+        if( label_ == nullptr ) {
+          snprintf( unknown_label_, sizeof( unknown_label_ ), "unknown (%u)", value );
+          label_ = unknown_label_;
+        }
+      }
+
+      void publish() override {
+        if( label_ != nullptr ) {
+          publish_state( label_ );
+        }
+      }
+
+    protected:
+      BsbEnumTable table_;
+      const char*  label_ = nullptr;
+      char         unknown_label_[24];
+    };
 #endif
 
 #ifdef USE_BINARY_SENSOR
@@ -145,6 +313,15 @@ namespace esphome {
 
       bool value_;
     };
+
+    template< typename Codec >
+    class BsbBinarySensorTyped : public BsbBinarySensor {
+    public:
+      const char* get_value_type_name() const override { return Codec::name(); }
+      void        decode( const BsbPacket* packet ) override {
+        set_value( Codec::valid( packet->payload ) ? bitfield_.extract( uint32_t( Codec::decode_raw( packet->payload ) ) ) : 0 );
+      }
+    };
 #endif
 
   } // namespace bsb
@@ -0,0 +1,247 @@
+#pragma once
+
+#include <algorithm>
+#include <cstdint>
+
+#include "bsbScheduling.h"
+
+namespace esphome {
+  namespace bsb {
+    // requests and the ones of them which collided, pe with a frame of another device
+    struct BsbCollisionStats {
+      uint32_t requests   = 0;
+      uint32_t collisions = 0;
+
+      const float rate() const { return requests != 0 ? 100.0f * collisions / requests : 0; }
+    };
+
+    // Slot alignment: learns the rhythm of the frames of the other devices on the bus, pe the INF telegrams of the
+    // heating system, and predicts when the bus is busy. Our telegrams are deferred into the gaps in between, so they
+    // don't collide. Every field ID of every device is a stream with its own period. A stream is only used for the
+    // prediction after a few frames in the same rhythm and is dropped when its frames stop. If the prediction is wrong,
+    // the guard around the predicted frames widens, and a telegram is never deferred for more than MaxDefer.
+    class BsbSlotPlanner {
+    public:
+      // a frame of another device was received completely
+      void observe( const uint32_t timestamp, const uint8_t source, const uint32_t field_id, const size_t length ) {
+        const uint32_t duration = bsb_frame_duration( length );
+        const uint32_t start    = timestamp - duration;
+
+        Stream* stream = find( source, field_id );
+        if( stream == nullptr ) {
+          stream = replace();
+          *stream = { source, field_id, start, 0, 0, duration, 0, true };
+          return;
+        }
+
+        const uint32_t interval = start - stream->start;
+        stream->start           = start;
+        stream->duration        = std::max( stream->duration, duration );
+
+        const uint32_t deviation = interval > stream->period ? interval - stream->period : stream->period - interval;
+        if( stream->hits != 0 && deviation <= stream->period / 4 ) {
+          stream->period = ( stream->period * 3 + interval ) / 4;
+          stream->jitter = ( stream->jitter * 3 + deviation ) / 4;
+          stream->hits   = std::min< uint8_t >( stream->hits + 1, UINT8_MAX );
+        } else {
+          // the first interval or a change of the rhythm, start over
+          stream->period = interval;
+          stream->jitter = 0;
+          stream->hits   = 1;
+        }
+      }
+
+      // true if at least one stream is regular enough to predict its frames
+      const bool is_predicting( const uint32_t timestamp ) const {
+        for( const auto& stream : streams_ ) {
+          if( is_regular( stream, timestamp ) ) {
+            return true;
+          }
+        }
+        return false;
+      }
+
+      // ms until a transaction doesn't overlap any predicted frame, capped by the deferral already spent
+      const uint32_t get_time_until_clear( const uint32_t timestamp ) const {
+        uint32_t clear = timestamp;
+        // moving behind one frame can hit the next one, so repeat until the window is free
+        for( size_t pass = 0; pass < MaxStreams; ++pass ) {
+          bool moved = false;
+          for( const auto& stream : streams_ ) {
+            if( !is_regular( stream, timestamp ) ) {
+              continue;
+            }
+            const uint32_t guard = margin_ + 2 * stream.jitter;
+            // the next frame which ends after the start of the window
+            const uint32_t frames = ( clear - stream.start + guard ) / stream.period;
+            for( uint32_t n = frames; n <= frames + 1; ++n ) {
+              const uint32_t busy_start = stream.start + n * stream.period - guard;
+              const uint32_t busy_end   = stream.start + n * stream.period + stream.duration + guard;
+              if( int32_t( busy_end - clear ) > 0 && int32_t( clear + TransactionWindow - busy_start ) > 0 ) {
+                clear = busy_end;
+                moved = true;
+              }
+            }
+          }
+          if( !moved ) {
+            break;
+          }
+        }
+
+        uint32_t wait = clear - timestamp;
+        if( deferring_ ) {
+          wait = std::min( wait, bsb_time_until_elapsed( timestamp, deferred_since_, MaxDefer ) );
+        }
+        return std::min( wait, MaxDefer );
+      }
+
+      // returns true if a telegram may be sent now, else the slot is deferred
+      const bool check( const uint32_t timestamp ) {
+        if( get_time_until_clear( timestamp ) == 0 ) {
+          if( deferring_ && ( timestamp - deferred_since_ ) >= MaxDefer ) {
+            ++fallbacks_;
+          }
+          deferring_ = false;
+          return true;
+        }
+        if( !deferring_ ) {
+          deferring_      = true;
+          deferred_since_ = timestamp;
+          ++deferrals_;
+        }
+        return false;
+      }
+
+      // the collisions are counted for the first of the requests in flight, like the link health does
+      void request_sent( const uint32_t timestamp, const bool aligned ) {
+        if( !pending_ ) {
+          pending_           = true;
+          pending_aligned_   = aligned;
+          pending_timestamp_ = timestamp;
+        }
+      }
+
+      void reply_received() {
+        if( pending_ ) {
+          resolve( false );
+        }
+      }
+
+      // a frame with a wrong CRC while our request is in flight, most likely a collision
+      void frame_corrupted() {
+        if( pending_ ) {
+          resolve( true );
+        }
+      }
+
+      void check_timeout( const uint32_t timestamp ) {
+        if( pending_ && ( timestamp - pending_timestamp_ ) >= ReplyTimeout ) {
+          resolve( true );
+        }
+      }
+
+      // ms until check_timeout() can count a collision
+      const uint32_t get_time_until_due( const uint32_t timestamp ) const {
+        return pending_ ? bsb_time_until_elapsed( timestamp, pending_timestamp_, ReplyTimeout ) : BsbNoDeadline;
+      }
+
+      // the requests sent without a prediction, pe while learning or without slot alignment, and the aligned ones
+      const BsbCollisionStats& get_unaligned() const { return unaligned_; }
+      const BsbCollisionStats& get_aligned() const { return aligned_; }
+
+      // the requests since the last call
+      const BsbCollisionStats take_window() {
+        const BsbCollisionStats window = window_;
+        window_                        = BsbCollisionStats();
+        return window;
+      }
+
+      const uint32_t get_deferrals() const { return deferrals_; }
+      const uint32_t get_fallbacks() const { return fallbacks_; }
+      const uint32_t get_margin() const { return margin_; }
+
+      static constexpr size_t   MaxStreams        = 16;
+      static constexpr uint8_t  HitsToPredict     = 3;
+      // a Get, the typical reply latency of the heating system and the reply, as in the bus budget
+      static constexpr uint32_t TransactionWindow = 160;
+      static constexpr uint32_t MaxDefer          = 1000;
+      static constexpr uint32_t ReplyTimeout      = 1000;
+      static constexpr uint32_t MinMargin         = 10;
+      static constexpr uint32_t MaxMargin         = 200;
+
+    private:
+      struct Stream {
+        uint8_t  source;
+        uint32_t field_id;
+        uint32_t start;
+        uint32_t period;
+        uint32_t jitter;
+        uint32_t duration;
+        uint8_t  hits;
+        bool     used;
+      };
+
+      // regular and still sending, a stream which missed two frames isn't predicted anymore
+      const bool is_regular( const Stream& stream, const uint32_t timestamp ) const {
+        return stream.used && stream.hits >= HitsToPredict && stream.period > stream.duration &&
+               ( timestamp - stream.start ) < 2 * stream.period + stream.duration;
+      }
+
+      Stream* find( const uint8_t source, const uint32_t field_id ) {
+        for( auto& stream : streams_ ) {
+          if( stream.used && stream.source == source && stream.field_id == field_id ) {
+            return &stream;
+          }
+        }
+        return nullptr;
+      }
+
+      // a free stream, or the one silent for the longest time
+      Stream* replace() {
+        Stream* oldest = &streams_[0];
+        for( auto& stream : streams_ ) {
+          if( !stream.used ) {
+            return &stream;
+          }
+          if( int32_t( stream.start - oldest->start ) < 0 ) {
+            oldest = &stream;
+          }
+        }
+        return oldest;
+      }
+
+      void resolve( const bool collision ) {
+        pending_ = false;
+
+        BsbCollisionStats& stats = pending_aligned_ ? aligned_ : unaligned_;
+        ++stats.requests;
+        ++window_.requests;
+        if( collision ) {
+          ++stats.collisions;
+          ++window_.collisions;
+        }
+
+        // a wrong prediction widens the guard around the predicted frames, it shrinks again with every hit
+        if( pending_aligned_ ) {
+          margin_ = collision ? std::min( margin_ * 2, MaxMargin ) : std::max( margin_ - 1, MinMargin );
+        }
+      }
+
+      Stream streams_[MaxStreams] = {};
+
+      uint32_t margin_         = MinMargin;
+      bool     deferring_      = false;
+      uint32_t deferred_since_ = 0;
+      uint32_t deferrals_      = 0;
+      uint32_t fallbacks_      = 0;
+
+      bool     pending_           = false;
+      bool     pending_aligned_   = false;
+      uint32_t pending_timestamp_ = 0;
+
+      BsbCollisionStats unaligned_;
+      BsbCollisionStats aligned_;
+      BsbCollisionStats window_;
+    };
+  }
+}
@@ -0,0 +1,123 @@
+#pragma once
+
+#include <cmath>
+#include <cstdint>
+#include <unordered_map>
+#include <vector>
+
+#include "bsbPacket.h"
+
+namespace esphome {
+  namespace bsb {
+    struct BsbValue {
+      std::vector< uint8_t > payload;
+      uint32_t               timestamp = 0;
+      bool                   valid     = false;
+
+      // how often the field is seen on the bus, averaged over the last few updates
+      uint32_t updates             = 0;
+      uint32_t average_interval_ms = 0;
+
+      const uint32_t get_age( const uint32_t now ) const { return now - timestamp; }
+    };
+
+    // a value of the store as seen by other code, pe in lambdas: id(bsb1).get_cached(0x053D0000).decode< BsbCodecTemperature >()
+    struct BsbCachedValue {
+      const BsbValue* value = nullptr;
+      uint32_t        age   = 0;
+
+      BsbCachedValue() = default;
+      BsbCachedValue( const BsbValue* value, const uint32_t now )
+          : value( value )
+          , age( value != nullptr && value->valid ? value->get_age( now ) : UINT32_MAX ) {}
+
+      const bool valid() const { return value != nullptr && value->valid; }
+
+      const std::vector< uint8_t >& payload() const {
+        static const std::vector< uint8_t > empty;
+        return valid() ? value->payload : empty;
+      }
+
+      template< typename Codec >
+      const float decode() const {
+        return valid() && Codec::valid( value->payload ) ? Codec::decode( value->payload ) : NAN;
+      }
+    };
+
+    // the last payload of every field seen on the bus, independent of the entities using it
+    class BsbValueStore {
+    public:
+      // entries are created when the entities get registered, so updating them doesn't allocate
+      void add_field( const uint32_t field_id ) {
+        BsbValue& value = values_[field_id];
+        value.payload.reserve( 16 );
+      }
+
+      const BsbValue* get( const uint32_t field_id ) const {
+        auto it = values_.find( field_id );
+        return it != values_.end() ? &it->second : nullptr;
+      }
+
+      const bool update( const BsbPacket* packet, const uint32_t now ) {
+        auto it = values_.find( packet->fieldId );
+        if( it == values_.end() ) {
+          return false;
+        }
+
+        BsbValue& value = it->second;
+        if( value.valid ) {
+          const uint32_t interval = value.get_age( now );
+          value.average_interval_ms =
+            value.updates == 1 ? interval : ( value.average_interval_ms * ( AverageWeight - 1 ) + interval ) / AverageWeight;
+        }
+        ++value.updates;
+
+        value.payload.assign( packet->payload.cbegin(), packet->payload.cend() );
+        value.timestamp = now;
+        value.valid     = true;
+
+        return true;
+      }
+
+      const size_t size() const { return values_.size(); }
+
+      std::unordered_map< uint32_t, BsbValue >::const_iterator begin() const { return values_.cbegin(); }
+      std::unordered_map< uint32_t, BsbValue >::const_iterator end() const { return values_.cend(); }
+
+      // Snapshot format, all numbers big endian like on the bus:
+      //   header: 'B', 'S', version, number of entries (uint16)
+      //   entry:  field ID (uint32), age in s (uint16, saturated at 0xFFFF), flags (bit 0: valid), payload length, payload
+      void snapshot( std::vector< uint8_t >& out, const uint32_t now ) const {
+        out.clear();
+        out.push_back( 'B' );
+        out.push_back( 'S' );
+        out.push_back( SnapshotVersion );
+        out.push_back( values_.size() >> 8 );
+        out.push_back( values_.size() );
+
+        for( const auto& item : values_ ) {
+          const BsbValue& value = item.second;
+
+          const uint32_t age           = value.valid ? value.get_age( now ) / 1000 : 0xFFFF;
+          const uint16_t age_saturated = age > 0xFFFF ? 0xFFFF : age;
+
+          out.push_back( item.first >> 24 );
+          out.push_back( item.first >> 16 );
+          out.push_back( item.first >> 8 );
+          out.push_back( item.first );
+          out.push_back( age_saturated >> 8 );
+          out.push_back( age_saturated );
+          out.push_back( value.valid ? 0x01 : 0x00 );
+          out.push_back( value.payload.size() );
+          out.insert( out.end(), value.payload.cbegin(), value.payload.cend() );
+        }
+      }
+
+      static constexpr uint8_t  SnapshotVersion = 1;
+      static constexpr uint32_t AverageWeight   = 8;
+
+    private:
+      std::unordered_map< uint32_t, BsbValue > values_;
+    };
+  }
+}
@@ -1,7 +1,7 @@
 import esphome.codegen as cg
 import esphome.config_validation as cv
 from esphome.components import number
-from . import BsbComponent, bsb_ns, CONF_BSB_ID, CONF_BSB_TYPE_ENUM, CONF_BSB_TYPE, CONF_PARAMETER_NUMBER
+from . import BsbComponent, bsb_ns, set_priority, PRIORITY_SCHEMA, CONF_BSB_ID, CONF_BSB_TYPE_ENUM, CONF_BSB_TYPE, CONF_PARAMETER_NUMBER
 
 from esphome.const import (
     CONF_ID, CONF_NAME,CONF_MAX_VALUE, CONF_MIN_VALUE, CONF_STEP, CONF_UPDATE_INTERVAL
@@ -12,8 +12,12 @@ CONF_DIVISOR = "divisor"
 CONF_FACTOR = "factor"
 CONF_ENABLE_BYTE = "enable_byte"
 CONF_BROADCAST = "broadcast"
+CONF_BROADCAST_INTERVAL = "broadcast_interval"
+CONF_BROADCAST_MIN_GAP = "broadcast_min_gap"
+CONF_VERIFY_AFTER_SET = "verify_after_set"
 
 BsbNumber = bsb_ns.class_("BsbNumber", number.Number)
+BsbNumberTyped = bsb_ns.class_("BsbNumberTyped", BsbNumber)
 
 # CONFIG_SCHEMA = number.NUMBER_SCHEMA.extend({
 #     cv.GenerateID(): cv.declare_id(BsbNumber),
@@ -25,7 +29,7 @@ BsbNumber = bsb_ns.class_("BsbNumber", number.Number)
 
 CONFIG_SCHEMA = cv.All(
     number.number_schema(
-        BsbNumber,
+        BsbNumberTyped,
     ).extend(
         {
             cv.GenerateID(CONF_BSB_ID): cv.use_id(BsbComponent),
@@ -33,6 +37,9 @@ CONFIG_SCHEMA = cv.All(
             cv.Optional(CONF_ENABLE_BYTE, default="1"): cv.hex_int_range(0x00,0xff), cv.Optional(CONF_PARAMETER_NUMBER, default="0"): cv.positive_int,
             cv.Required(CONF_BSB_TYPE): cv.enum(CONF_BSB_TYPE_ENUM, upper=True, space="_"),
             cv.Optional(CONF_BROADCAST, default=False): cv.boolean,
+            cv.Optional(CONF_BROADCAST_INTERVAL, default="0s"): cv.positive_time_period_milliseconds,
+            cv.Optional(CONF_BROADCAST_MIN_GAP, default="1s"): cv.positive_time_period_milliseconds,
+            cv.Optional(CONF_VERIFY_AFTER_SET, default=True): cv.boolean,
             cv.Optional(CONF_UPDATE_INTERVAL, default="15min"): cv.update_interval,
             cv.Required(CONF_MIN_VALUE): cv.float_,
             cv.Required(CONF_MAX_VALUE): cv.float_,
@@ -40,7 +47,7 @@ CONFIG_SCHEMA = cv.All(
             cv.Optional(CONF_DIVISOR, default="1"): cv.float_,
             cv.Optional(CONF_FACTOR, default="1"): cv.float_,
         }
-    ),
+    ).extend(PRIORITY_SCHEMA),
     cv.has_exactly_one_key(CONF_FIELD_ID),
 )
 
@@ -50,7 +57,7 @@ async def to_code(config):
     config.min_value = 0
     config.max_value = 100
     config.step = 0.1
-    var = await number.new_number(config,min_value=config[CONF_MIN_VALUE], max_value=config[CONF_MAX_VALUE], step=config[CONF_STEP])
+    var = await number.new_number(config, cg.TemplateArguments(config[CONF_BSB_TYPE]), min_value=config[CONF_MIN_VALUE], max_value=config[CONF_MAX_VALUE], step=config[CONF_STEP])
 
 
     if CONF_FIELD_ID in config:
@@ -62,6 +69,15 @@ async def to_code(config):
     if CONF_BROADCAST in config:
         cg.add(var.set_broadcast(config[CONF_BROADCAST]))
 
+    if CONF_BROADCAST_INTERVAL in config:
+        cg.add(var.set_broadcast_interval(config[CONF_BROADCAST_INTERVAL]))
+
+    if CONF_BROADCAST_MIN_GAP in config:
+        cg.add(var.set_broadcast_min_gap(config[CONF_BROADCAST_MIN_GAP]))
+
+    if CONF_VERIFY_AFTER_SET in config:
+        cg.add(var.set_verify_after_set(config[CONF_VERIFY_AFTER_SET]))
+
     # if CONF_PARAMETER_NUMBER in config:
     #     cg.add(var.set_parameter_number(config[CONF_PARAMETER_NUMBER]))
 
@@ -71,12 +87,11 @@ async def to_code(config):
     if CONF_FACTOR in config:
         cg.add(var.set_factor(config[CONF_FACTOR]))
 
-    if CONF_BSB_TYPE in config:
-        cg.add(var.set_value_type(config[CONF_BSB_TYPE]))
-
     if CONF_UPDATE_INTERVAL in config:
         cg.add(var.set_update_interval(config[CONF_UPDATE_INTERVAL]))
 
+    await set_priority(var, config)
+
     cg.add(component.register_number(var))
     cg.add(var.set_retry_interval(component.get_retry_interval()))
     cg.add(var.set_retry_count(component.get_retry_count()))
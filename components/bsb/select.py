@@ -0,0 +1,76 @@
+import esphome.codegen as cg
+import esphome.config_validation as cv
+from esphome.components import select
+from . import (
+    BsbComponent,
+    bsb_ns,
+    enum_options,
+    enum_table,
+    set_priority,
+    BsbEnumEntry,
+    PRIORITY_SCHEMA,
+    CONF_BSB_ID,
+    CONF_PARAMETER_NUMBER,
+    CONF_BSB_ENUM_TYPE_ENUM,
+    CONF_BSB_TYPE,
+    CONF_ENUM_TABLE_ID
+)
+
+from esphome.const import (
+    CONF_OPTIONS,
+    CONF_UPDATE_INTERVAL
+)
+
+CONF_FIELD_ID = "field_id"
+CONF_ENABLE_BYTE = "enable_byte"
+CONF_VERIFY_AFTER_SET = "verify_after_set"
+
+BsbSelect = bsb_ns.class_("BsbSelect", select.Select)
+BsbSelectTyped = bsb_ns.class_("BsbSelectTyped", BsbSelect)
+
+CONFIG_SCHEMA = cv.All(
+    select.select_schema(
+        BsbSelectTyped,
+    ).extend(
+        {
+            cv.GenerateID(CONF_BSB_ID): cv.use_id(BsbComponent),
+            cv.GenerateID(CONF_ENUM_TABLE_ID): cv.declare_id(BsbEnumEntry),
+            cv.Required(CONF_FIELD_ID): cv.positive_int,
+            cv.Optional(CONF_ENABLE_BYTE, default="1"): cv.hex_int_range(0x00,0xff),
+            cv.Optional(CONF_PARAMETER_NUMBER, default="0"): cv.positive_int,
+            cv.Optional(CONF_BSB_TYPE, default="ENUM"): cv.enum(CONF_BSB_ENUM_TYPE_ENUM, upper=True, space="_"),
+            cv.Required(CONF_OPTIONS): enum_options,
+            cv.Optional(CONF_VERIFY_AFTER_SET, default=True): cv.boolean,
+            cv.Optional(CONF_UPDATE_INTERVAL, default="15min"): cv.update_interval,
+        }
+    ).extend(PRIORITY_SCHEMA),
+    cv.has_exactly_one_key(CONF_FIELD_ID),
+)
+
+
+async def to_code(config):
+    component = await cg.get_variable(config[CONF_BSB_ID])
+    options = config[CONF_OPTIONS]
+    var = await select.new_select(
+        config, cg.TemplateArguments(config[CONF_BSB_TYPE]), options=[options[raw] for raw in sorted(options)]
+    )
+
+    await enum_table(var, config, options)
+
+    if CONF_FIELD_ID in config:
+        cg.add(var.set_field_id(config[CONF_FIELD_ID]))
+
+    if CONF_ENABLE_BYTE in config:
+        cg.add(var.set_enable_byte(config[CONF_ENABLE_BYTE]))
+
+    if CONF_VERIFY_AFTER_SET in config:
+        cg.add(var.set_verify_after_set(config[CONF_VERIFY_AFTER_SET]))
+
+    if CONF_UPDATE_INTERVAL in config:
+        cg.add(var.set_update_interval(config[CONF_UPDATE_INTERVAL]))
+
+    await set_priority(var, config)
+
+    cg.add(component.register_number(var))
+    cg.add(var.set_retry_interval(component.get_retry_interval()))
+    cg.add(var.set_retry_count(component.get_retry_count()))
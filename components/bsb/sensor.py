@@ -1,9 +1,29 @@
 import esphome.codegen as cg
 import esphome.config_validation as cv
 from esphome.components import sensor
-from . import BsbComponent, bsb_ns, CONF_BSB_ID, CONF_PARAMETER_NUMBER, CONF_BSB_TYPE_ENUM, CONF_BSB_TYPE
+from . import (
+    BsbComponent,
+    BsbGroup,
+    bsb_ns,
+    bus_query_interval,
+    interval_seconds,
+    register_group_member,
+    set_bitfield,
+    set_priority,
+    validate_bitfield,
+    BITFIELD_SCHEMA,
+    PRIORITY_SCHEMA,
+    CONF_BSB_ID,
+    CONF_GROUP,
+    CONF_PARAMETER_NUMBER,
+    CONF_BSB_INTEGER_TYPE_ENUM,
+    CONF_BSB_TYPE_ENUM,
+    CONF_BSB_TYPE
+)
 
 from esphome.const import (
+    CONF_MAX,
+    CONF_MIN,
     CONF_UPDATE_INTERVAL
 )
 
@@ -11,12 +31,47 @@ CONF_FIELD_ID = "field_id"
 CONF_DIVISOR = "divisor"
 CONF_FACTOR = "factor"
 CONF_ENABLE_BYTE = "enable_byte"
+CONF_AGGREGATE = "aggregate"
+CONF_WINDOW = "window"
+CONF_MEAN = "mean"
+
+# the samples of a window are kept in a fixed-size ring, so the window can't hold an arbitrary number of samples
+AGGREGATE_MAX_SAMPLES = 255
 
 BsbSensor = bsb_ns.class_("BsbSensor", sensor.Sensor)
+BsbSensorTyped = bsb_ns.class_("BsbSensorTyped", BsbSensor)
+
+def aggregate_samples(config, interval_ms):
+    return int(config[CONF_AGGREGATE][CONF_WINDOW].total_milliseconds // interval_ms) + 1
+
+
+def aggregate_capacity(config):
+    # Besides the own polls, samples arrive with the polls of other entities of the same field or of the group, after a
+    # refresh or a changed update_interval and with the INF telegrams of the heating system. The polls are at least one
+    # query interval apart, so the ring is sized for that. If it still fills up, the window is closed early.
+    fastest = bus_query_interval(config[CONF_BSB_ID])
+    own = interval_seconds(config[CONF_UPDATE_INTERVAL])
+    if own is not None:
+        fastest = min(fastest, own * 1000) if fastest else own * 1000
+    if not fastest:
+        return AGGREGATE_MAX_SAMPLES
+    return min(aggregate_samples(config, fastest), AGGREGATE_MAX_SAMPLES)
+
+
+def validate_aggregate(config):
+    if CONF_AGGREGATE in config:
+        # with update_interval: never, the samples only come from the other sources
+        own = interval_seconds(config[CONF_UPDATE_INTERVAL])
+        if own is not None and aggregate_samples(config, own * 1000) > AGGREGATE_MAX_SAMPLES:
+            raise cv.Invalid(
+                f"The aggregate window holds more than {AGGREGATE_MAX_SAMPLES} samples, increase the update_interval or shorten the window"
+            )
+    return config
+
 
 CONFIG_SCHEMA = cv.All(
     sensor.sensor_schema(
-        BsbSensor,
+        BsbSensorTyped,
     ).extend(
         {
             cv.GenerateID(CONF_BSB_ID): cv.use_id(BsbComponent),
@@ -25,17 +80,28 @@ CONFIG_SCHEMA = cv.All(
             cv.Optional(CONF_PARAMETER_NUMBER, default="0"): cv.positive_int,
             cv.Required(CONF_BSB_TYPE): cv.enum(CONF_BSB_TYPE_ENUM, upper=True, space="_"),
             cv.Optional(CONF_UPDATE_INTERVAL, default="15min"): cv.update_interval,
+            cv.Optional(CONF_GROUP): cv.use_id(BsbGroup),
             cv.Optional(CONF_DIVISOR, default="1"): cv.float_,
             cv.Optional(CONF_FACTOR, default="1"): cv.float_,
+            cv.Optional(CONF_AGGREGATE): cv.Schema(
+                {
+                    cv.Required(CONF_WINDOW): cv.positive_time_period_milliseconds,
+                    cv.Optional(CONF_MIN): sensor.sensor_schema(),
+                    cv.Optional(CONF_MAX): sensor.sensor_schema(),
+                    cv.Optional(CONF_MEAN): sensor.sensor_schema(),
+                }
+            ),
         }
-    ),
+    ).extend(BITFIELD_SCHEMA, PRIORITY_SCHEMA),
     cv.has_exactly_one_key(CONF_FIELD_ID),
+    validate_aggregate,
+    validate_bitfield(CONF_BSB_INTEGER_TYPE_ENUM),
 )
 
 
 async def to_code(config):
     component = await cg.get_variable(config[CONF_BSB_ID])
-    var = await sensor.new_sensor(config)
+    var = await sensor.new_sensor(config, cg.TemplateArguments(config[CONF_BSB_TYPE]))
 
     if CONF_FIELD_ID in config:
         cg.add(var.set_field_id(config[CONF_FIELD_ID]))
@@ -49,12 +115,31 @@ async def to_code(config):
     if CONF_ENABLE_BYTE in config:
         cg.add(var.set_enable_byte(config[CONF_ENABLE_BYTE]))
 
-    if CONF_BSB_TYPE in config:
-        cg.add(var.set_value_type(config[CONF_BSB_TYPE]))
-
     if CONF_UPDATE_INTERVAL in config:
         cg.add(var.set_update_interval(config[CONF_UPDATE_INTERVAL]))
 
+    await set_bitfield(var, config)
+
+    if CONF_AGGREGATE in config:
+        aggregate = config[CONF_AGGREGATE]
+        cg.add(var.set_aggregate(aggregate[CONF_WINDOW], aggregate_capacity(config)))
+
+        if CONF_MIN in aggregate:
+            sens = await sensor.new_sensor(aggregate[CONF_MIN])
+            cg.add(var.set_min_sensor(sens))
+
+        if CONF_MAX in aggregate:
+            sens = await sensor.new_sensor(aggregate[CONF_MAX])
+            cg.add(var.set_max_sensor(sens))
+
+        if CONF_MEAN in aggregate:
+            sens = await sensor.new_sensor(aggregate[CONF_MEAN])
+            cg.add(var.set_mean_sensor(sens))
+
+    await set_priority(var, config)
+
+    await register_group_member(var, config)
+
     cg.add(component.register_sensor(var))
     cg.add(var.set_retry_interval(component.get_retry_interval()))
     cg.add(var.set_retry_count(component.get_retry_count()))
@@ -1,7 +1,7 @@
 import esphome.codegen as cg
 import esphome.config_validation as cv
 from esphome.components import switch
-from . import BsbComponent, bsb_ns, CONF_BSB_ID, CONF_PARAMETER_NUMBER, CONF_BSB_TYPE_ENUM, CONF_BSB_TYPE
+from . import BsbComponent, bsb_ns, set_priority, PRIORITY_SCHEMA, CONF_BSB_ID, CONF_PARAMETER_NUMBER, CONF_BSB_INTEGER_TYPE_ENUM, CONF_BSB_TYPE
 
 from esphome.const import (
     CONF_UPDATE_INTERVAL
@@ -11,31 +11,34 @@ CONF_FIELD_ID = "field_id"
 CONF_ON_VALUE = "on_value"
 CONF_OFF_VALUE = "off_value"
 CONF_ENABLE_BYTE = "enable_byte"
+CONF_VERIFY_AFTER_SET = "verify_after_set"
 
 BsbSwitch = bsb_ns.class_("BsbSwitch", switch.Switch)
+BsbSwitchTyped = bsb_ns.class_("BsbSwitchTyped", BsbSwitch)
 
 CONFIG_SCHEMA = cv.All(
     switch.switch_schema(
-        BsbSwitch,
+        BsbSwitchTyped,
     ).extend(
         {
             cv.GenerateID(CONF_BSB_ID): cv.use_id(BsbComponent),
             cv.Required(CONF_FIELD_ID): cv.positive_int,
             cv.Optional(CONF_ENABLE_BYTE, default="1"): cv.hex_int_range(0x00,0xff),
             cv.Optional(CONF_PARAMETER_NUMBER, default="0"): cv.positive_int,
-            cv.Optional(CONF_BSB_TYPE, default="INT8"): cv.enum(CONF_BSB_TYPE_ENUM, upper=True, space="_"),
+            cv.Optional(CONF_BSB_TYPE, default="INT8"): cv.enum(CONF_BSB_INTEGER_TYPE_ENUM, upper=True, space="_"),
+            cv.Optional(CONF_VERIFY_AFTER_SET, default=True): cv.boolean,
             cv.Optional(CONF_UPDATE_INTERVAL, default="15min"): cv.update_interval,
             cv.Optional(CONF_OFF_VALUE, default="0"): cv.float_,
             cv.Optional(CONF_ON_VALUE, default="1"): cv.float_,
         }
-    ),
+    ).extend(PRIORITY_SCHEMA),
     cv.has_exactly_one_key(CONF_FIELD_ID),
 )
 
 
 async def to_code(config):
     component = await cg.get_variable(config[CONF_BSB_ID])
-    var = await switch.new_switch(config)
+    var = await switch.new_switch(config, cg.TemplateArguments(config[CONF_BSB_TYPE]))
 
     if CONF_FIELD_ID in config:
         cg.add(var.set_field_id(config[CONF_FIELD_ID]))
@@ -49,12 +52,14 @@ async def to_code(config):
     if CONF_ENABLE_BYTE in config:
         cg.add(var.set_enable_byte(config[CONF_ENABLE_BYTE]))
 
-    if CONF_BSB_TYPE in config:
-        cg.add(var.set_value_type(config[CONF_BSB_TYPE]))
+    if CONF_VERIFY_AFTER_SET in config:
+        cg.add(var.set_verify_after_set(config[CONF_VERIFY_AFTER_SET]))
 
     if CONF_UPDATE_INTERVAL in config:
         cg.add(var.set_update_interval(config[CONF_UPDATE_INTERVAL]))
 
+    await set_priority(var, config)
+
     cg.add(component.register_number(var))
     cg.add(var.set_retry_interval(component.get_retry_interval()))
     cg.add(var.set_retry_count(component.get_retry_count()))
@@ -1,44 +1,88 @@
 import esphome.codegen as cg
 import esphome.config_validation as cv
 from esphome.components import text_sensor
-from . import BsbComponent, bsb_ns, CONF_BSB_ID, CONF_PARAMETER_NUMBER, CONF_BSB_TYPE_ENUM, CONF_BSB_TYPE
+from . import (
+    BsbComponent,
+    BsbGroup,
+    bsb_ns,
+    register_group_member,
+    set_bitfield,
+    set_priority,
+    enum_options,
+    enum_table,
+    BsbEnumEntry,
+    BITFIELD_SCHEMA,
+    PRIORITY_SCHEMA,
+    CONF_BSB_ID,
+    CONF_GROUP,
+    CONF_PARAMETER_NUMBER,
+    CONF_BSB_TEXT_TYPE_ENUM,
+    CONF_BSB_ENUM_TYPE_ENUM,
+    CONF_BSB_TYPE,
+    CONF_ENUM_TABLE_ID
+)
 
 from esphome.const import (
+    CONF_OPTIONS,
     CONF_UPDATE_INTERVAL
 )
 
 CONF_FIELD_ID = "field_id"
 
 BsbTextSensor = bsb_ns.class_("BsbTextSensor", text_sensor.TextSensor)
+BsbTextSensorTyped = bsb_ns.class_("BsbTextSensorTyped", BsbTextSensor)
+BsbEnumTextSensor = bsb_ns.class_("BsbEnumTextSensor", BsbTextSensor)
+
+BSB_TEXT_SENSOR_SCHEMA = cv.Schema(
+    {
+        cv.GenerateID(CONF_BSB_ID): cv.use_id(BsbComponent),
+        cv.Required(CONF_FIELD_ID): cv.positive_int,
+        cv.Optional(CONF_PARAMETER_NUMBER, default="0"): cv.positive_int,
+        cv.Optional(CONF_UPDATE_INTERVAL, default="15min"): cv.update_interval,
+        cv.Optional(CONF_GROUP): cv.use_id(BsbGroup),
+    }
+).extend(PRIORITY_SCHEMA)
+
+TEXT_SCHEMA = text_sensor.text_sensor_schema(BsbTextSensorTyped).extend(BSB_TEXT_SENSOR_SCHEMA)
+
+ENUM_SCHEMA = text_sensor.text_sensor_schema(BsbEnumTextSensor).extend(BSB_TEXT_SENSOR_SCHEMA, BITFIELD_SCHEMA).extend(
+    {
+        cv.GenerateID(CONF_ENUM_TABLE_ID): cv.declare_id(BsbEnumEntry),
+        cv.Required(CONF_OPTIONS): enum_options,
+    }
+)
 
-CONFIG_SCHEMA = cv.All(
-    text_sensor.text_sensor_schema(
-        BsbTextSensor,
-    ).extend(
-        {
-            cv.GenerateID(CONF_BSB_ID): cv.use_id(BsbComponent),
-            cv.Required(CONF_FIELD_ID): cv.positive_int,
-            cv.Optional(CONF_PARAMETER_NUMBER, default="0"): cv.positive_int,
-            cv.Optional(CONF_UPDATE_INTERVAL, default="15min"): cv.update_interval,
-        }
-    ),
-    cv.has_exactly_one_key(CONF_FIELD_ID),
+CONFIG_SCHEMA = cv.typed_schema(
+    {
+        **{value_type: TEXT_SCHEMA for value_type in CONF_BSB_TEXT_TYPE_ENUM},
+        **{value_type: ENUM_SCHEMA for value_type in CONF_BSB_ENUM_TYPE_ENUM},
+    },
+    key=CONF_BSB_TYPE,
+    default_type="TEXT",
+    upper=True,
 )
 
 
 async def to_code(config):
     component = await cg.get_variable(config[CONF_BSB_ID])
-    var = await text_sensor.new_text_sensor(config)
+
+    if config[CONF_BSB_TYPE] in CONF_BSB_ENUM_TYPE_ENUM:
+        var = await text_sensor.new_text_sensor(config, cg.TemplateArguments(CONF_BSB_ENUM_TYPE_ENUM[config[CONF_BSB_TYPE]]))
+        await enum_table(var, config, config[CONF_OPTIONS])
+        await set_bitfield(var, config)
+    else:
+        var = await text_sensor.new_text_sensor(config, cg.TemplateArguments(CONF_BSB_TEXT_TYPE_ENUM[config[CONF_BSB_TYPE]]))
 
     if CONF_FIELD_ID in config:
         cg.add(var.set_field_id(config[CONF_FIELD_ID]))
 
-    if CONF_BSB_TYPE in config:
-        cg.add(var.set_value_type(config[CONF_BSB_TYPE]))
-
     if CONF_UPDATE_INTERVAL in config:
         cg.add(var.set_update_interval(config[CONF_UPDATE_INTERVAL]))
 
+    await set_priority(var, config)
+
+    await register_group_member(var, config)
+
     cg.add(component.register_sensor(var))
     cg.add(var.set_retry_interval(component.get_retry_interval()))
     cg.add(var.set_retry_count(component.get_retry_count()))
@@ -0,0 +1,142 @@
+// The steady state of the component doesn't allocate: once the buffers have grown to the largest telegram, the loop,
+// the receive path and the send path run without a single heap allocation, counted by the operator new of the
+// allocation audit (see bsbAllocationAudit.h). The log runs at DEBUG, the default level of ESPHome, so the logs of every
+// telegram are counted as well.
+
+#include <gtest/gtest.h>
+
+#include <cstdint>
+#include <cstdio>
+
+#include "bsb_simulation.h"
+
+using namespace esphome;
+using namespace esphome::bsb;
+
+namespace {
+  constexpr uint64_t WarmUp = 10 * 60 * 1000;
+  constexpr uint64_t Period = 60 * 60 * 1000;
+
+  // logs at DEBUG into /dev/null for the lifetime of a test; its buffer is allocated with the first line of the warm-up
+  class DebugLog {
+  public:
+    DebugLog() : file_( fopen( "/dev/null", "w" ) ) {
+      host::set_log_file( file_ );
+      host::set_log_level( host::LogLevelDebug );
+    }
+    ~DebugLog() {
+      host::set_log_level( host::LogLevelNone );
+      host::set_log_file( nullptr );
+      fclose( file_ );
+    }
+
+  private:
+    FILE* file_;
+  };
+
+  void add_entities( SimulatedBus& bus ) {
+    for( uint32_t i = 0; i < 8; ++i ) {
+      make_sensor< BsbSensorTyped< BsbCodecTemperature > >( bus.component, 0x0D3D0500 + i, 5000 );
+      bus.controller.add_field< BsbCodecTemperature >( 0x0D3D0500 + i, 20.0f + i, 4.0f );
+    }
+    make_sensor< BsbSensorTyped< BsbCodecInt32 > >( bus.component, 0x193D2FBF, 10000 );
+    bus.controller.add_field< BsbCodecInt32 >( 0x193D2FBF, 123456 );
+    make_sensor< BsbSensorTyped< BsbCodecPercentHalf > >( bus.component, 0x053D0F66, 10000 );
+    bus.controller.add_field< BsbCodecPercentHalf >( 0x053D0F66, 40, 20 );
+
+    make_number< BsbNumberTyped< BsbCodecTemperature > >( bus.component, 0x2D3D058E, 10000 );
+    bus.controller.add_field< BsbCodecTemperature >( 0x2D3D058E, 21.0f );
+
+    auto* room = make_number< BsbNumberTyped< BsbCodecRoomTemperature > >( bus.component, 0x2D3D0215, SCHEDULER_DONT_RUN );
+    room->set_broadcast( true );
+    room->set_broadcast_interval( 30000 );
+    room->make_call( 21.5f );
+  }
+
+  // the allocations of the component alone, without the ones of the simulated controllers
+  const uint32_t run_counted( Simulation& simulation, const uint64_t end ) {
+    uint32_t allocations = 0;
+    while( host::get_time() / 1000 < end ) {
+      for( size_t i = 0; i < simulation.size(); ++i ) {
+        simulation.get_bus( i ).controller.poll();
+      }
+
+      const uint32_t before = BsbAllocationCounters::allocations;
+      const uint32_t now    = millis();
+      for( size_t i = 0; i < simulation.size(); ++i ) {
+        simulation.get_bus( i ).component.step();
+      }
+      if( simulation.get_engine() != nullptr ) {
+        simulation.get_engine()->run_scheduler( now );
+        simulation.get_engine()->loop();
+      }
+      allocations += BsbAllocationCounters::allocations - before;
+
+      host::advance_time( 1000 );
+    }
+    return allocations;
+  }
+
+  void expect_steady_state_without_allocations( Simulation& simulation ) {
+    simulation.setup();
+    simulation.run_until( WarmUp );
+
+    const BsbAllocationStats receive = simulation.get_bus( 0 ).component.get_allocations_receive();
+    const BsbAllocationStats send    = simulation.get_bus( 0 ).component.get_allocations_send();
+    const uint32_t           replies = simulation.get_bus( 0 ).controller.get_replies();
+
+    EXPECT_EQ( run_counted( simulation, WarmUp + Period ), 0u );
+
+    const BsbAllocationStats& receive_after = simulation.get_bus( 0 ).component.get_allocations_receive();
+    const BsbAllocationStats& send_after    = simulation.get_bus( 0 ).component.get_allocations_send();
+    // the polls went on
+    EXPECT_GT( simulation.get_bus( 0 ).controller.get_replies(), replies + 1000 );
+    EXPECT_GT( receive_after.events, receive.events );
+    EXPECT_GT( send_after.events, send.events );
+    EXPECT_EQ( receive_after.allocations, receive.allocations );
+    EXPECT_EQ( send_after.allocations, send.allocations );
+  }
+}
+
+TEST( BsbAllocation, SteadyStateDoesNotAllocate ) {
+  host::set_time( 0 );
+  DebugLog   log;
+  Simulation simulation;
+  add_entities( simulation.add_bus() );
+
+  expect_steady_state_without_allocations( simulation );
+}
+
+TEST( BsbAllocation, SetsDoNotAllocate ) {
+  host::set_time( 0 );
+  DebugLog      log;
+  Simulation    simulation;
+  SimulatedBus& bus = simulation.add_bus();
+  add_entities( bus );
+  auto* number = make_number< BsbNumberTyped< BsbCodecTemperature > >( bus.component, 0x2D3D0590, 10000 );
+  bus.controller.add_field< BsbCodecTemperature >( 0x2D3D0590, 19.0f );
+
+  simulation.setup();
+  simulation.run_until( WarmUp );
+  number->make_call( 20.5f );
+  simulation.run_until( WarmUp + 60000 );
+
+  const uint32_t sets = bus.controller.get_sets();
+  const uint64_t end  = WarmUp + 2 * 60000;
+  number->make_call( 22.0f );
+  EXPECT_EQ( run_counted( simulation, end ), 0u );
+  EXPECT_GT( bus.controller.get_sets(), sets );
+  EXPECT_EQ( number->state, 22.0f );
+}
+
+TEST( BsbAllocation, MultiBusDoesNotAllocate ) {
+  host::set_time( 0 );
+  DebugLog   log;
+  Simulation simulation;
+  for( int i = 0; i < 3; ++i ) {
+    add_entities( simulation.add_bus() );
+  }
+  simulation.use_engine();
+
+  expect_steady_state_without_allocations( simulation );
+}
@@ -0,0 +1,190 @@
+// Micro-benchmarks of the protocol core: frame build, parse, CRC and the decoding and encoding of every value type.
+//
+//   cmake -S . -B build && cmake --build build && build/host/bsb_core_benchmark
+
+#include <benchmark/benchmark.h>
+
+#include <cstdint>
+#include <vector>
+
+#include "bsbCodec.h"
+#include "bsbPacket.h"
+#include "bsbPacketReceive.h"
+#include "bsbPacketSend.h"
+
+using namespace esphome::bsb;
+
+namespace {
+  constexpr uint8_t  SourceAddress      = 0x42;
+  constexpr uint8_t  DestinationAddress = 0x00;
+  constexpr uint32_t FieldId            = 0x0D3D0519;
+
+  // a reply of the heating system with the payload of the codec, as the receiver sees it
+  template< typename Codec >
+  const BsbPacket make_ret( const float value ) {
+    BsbPacket packet;
+    packet.command            = BsbPacket::Command::Ret;
+    packet.sourceAddress      = DestinationAddress;
+    packet.destinationAddress = SourceAddress;
+    packet.fieldId            = FieldId;
+    Codec::encode_set( packet.payload, value, 0x01 );
+    packet.create_packet();
+    return packet;
+  }
+
+  template< typename Codec >
+  const BsbPayload make_payload( const float value ) {
+    BsbPayload payload;
+    Codec::encode_set( payload, value, 0x01 );
+    return payload;
+  }
+}
+
+static void BM_Crc( benchmark::State& state ) {
+  const std::vector< uint8_t > frame( state.range( 0 ), 0xA5 );
+
+  for( auto _ : state ) {
+    benchmark::DoNotOptimize( BsbPacket::CRC( frame.cbegin(), frame.cend() ) );
+  }
+  state.SetBytesProcessed( int64_t( state.iterations() ) * state.range( 0 ) );
+}
+BENCHMARK( BM_Crc )->Arg( BsbPacket::PacketSizeWithoutPyload - 2 )->Arg( 16 )->Arg( 32 );
+
+// into a reused packet, like the component sends them
+static void BM_BuildGet( benchmark::State& state ) {
+  BsbPacket packet;
+  for( auto _ : state ) {
+    benchmark::DoNotOptimize( bsb_build_get( packet, SourceAddress, DestinationAddress, FieldId ).buffer.data() );
+  }
+}
+BENCHMARK( BM_BuildGet );
+
+template< typename Codec >
+static void BM_BuildSet( benchmark::State& state ) {
+  BsbPacket packet;
+  for( auto _ : state ) {
+    benchmark::DoNotOptimize( bsb_build_set< Codec >( packet, SourceAddress, DestinationAddress, FieldId, 21.5f, 0x01 ).buffer.data() );
+  }
+}
+BENCHMARK_TEMPLATE( BM_BuildSet, BsbCodecUInt8 );
+BENCHMARK_TEMPLATE( BM_BuildSet, BsbCodecTemperature );
+BENCHMARK_TEMPLATE( BM_BuildSet, BsbCodecInt32 );
+
+template< typename Codec >
+static void BM_BuildInf( benchmark::State& state ) {
+  BsbPacket packet;
+  for( auto _ : state ) {
+    benchmark::DoNotOptimize( bsb_build_inf< Codec >( packet, SourceAddress, FieldId, 21.5f, 0x01 ).buffer.data() );
+  }
+}
+BENCHMARK_TEMPLATE( BM_BuildInf, BsbCodecRoomTemperature );
+
+// one complete frame through the state machine of the receiver, including the CRC check
+template< typename Codec >
+static void BM_Parse( benchmark::State& state ) {
+  const BsbPacket ret = make_ret< Codec >( 21.5f );
+
+  uint32_t         frames = 0;
+  BsbPacketReceive receive( [&frames]( const BsbPacket* ) { ++frames; } );
+
+  for( auto _ : state ) {
+    for( const uint8_t data : ret.buffer ) {
+      receive.loop( data );
+    }
+  }
+
+  if( frames != state.iterations() ) {
+    state.SkipWithError( "frames got lost" );
+  }
+  state.SetBytesProcessed( int64_t( state.iterations() ) * ret.buffer.size() );
+  state.counters["frames/s"] = benchmark::Counter( frames, benchmark::Counter::kIsRate );
+}
+BENCHMARK_TEMPLATE( BM_Parse, BsbCodecUInt8 );
+BENCHMARK_TEMPLATE( BM_Parse, BsbCodecTemperature );
+BENCHMARK_TEMPLATE( BM_Parse, BsbCodecInt32 );
+
+// a frame with a wrong CRC, pe after a collision
+static void BM_ParseCorrupted( benchmark::State& state ) {
+  BsbPacket ret = make_ret< BsbCodecTemperature >( 21.5f );
+  ret.buffer.back() ^= 0xFF;
+
+  BsbPacketReceive receive( []( const BsbPacket* ) {} );
+
+  for( auto _ : state ) {
+    for( const uint8_t data : ret.buffer ) {
+      receive.loop( data );
+    }
+  }
+
+  if( receive.get_crc_errors() != state.iterations() ) {
+    state.SkipWithError( "corrupted frames got accepted" );
+  }
+  state.SetBytesProcessed( int64_t( state.iterations() ) * ret.buffer.size() );
+}
+BENCHMARK( BM_ParseCorrupted );
+
+template< typename Codec >
+static void BM_Decode( benchmark::State& state ) {
+  const BsbPayload payload = make_payload< Codec >( 21.5f );
+
+  for( auto _ : state ) {
+    benchmark::DoNotOptimize( Codec::decode( payload ) );
+  }
+}
+BENCHMARK_TEMPLATE( BM_Decode, BsbCodecUInt8 );
+BENCHMARK_TEMPLATE( BM_Decode, BsbCodecInt8 );
+BENCHMARK_TEMPLATE( BM_Decode, BsbCodecUInt16 );
+BENCHMARK_TEMPLATE( BM_Decode, BsbCodecInt16 );
+BENCHMARK_TEMPLATE( BM_Decode, BsbCodecUInt32 );
+BENCHMARK_TEMPLATE( BM_Decode, BsbCodecInt32 );
+BENCHMARK_TEMPLATE( BM_Decode, BsbCodecTemperature );
+BENCHMARK_TEMPLATE( BM_Decode, BsbCodecPercentHalf );
+BENCHMARK_TEMPLATE( BM_Decode, BsbCodecWeekday );
+BENCHMARK_TEMPLATE( BM_Decode, BsbCodecEnum );
+BENCHMARK_TEMPLATE( BM_Decode, BsbCodecEnum16 );
+BENCHMARK_TEMPLATE( BM_Decode, BsbCodecRoomTemperature );
+
+template< typename Codec >
+static void BM_Encode( benchmark::State& state ) {
+  BsbPayload payload;
+  payload.reserve( 16 );
+
+  for( auto _ : state ) {
+    payload.clear();
+    Codec::encode_set( payload, 21.5f, 0x01 );
+    benchmark::DoNotOptimize( payload.data() );
+  }
+}
+BENCHMARK_TEMPLATE( BM_Encode, BsbCodecUInt8 );
+BENCHMARK_TEMPLATE( BM_Encode, BsbCodecInt8 );
+BENCHMARK_TEMPLATE( BM_Encode, BsbCodecUInt16 );
+BENCHMARK_TEMPLATE( BM_Encode, BsbCodecInt16 );
+BENCHMARK_TEMPLATE( BM_Encode, BsbCodecUInt32 );
+BENCHMARK_TEMPLATE( BM_Encode, BsbCodecInt32 );
+BENCHMARK_TEMPLATE( BM_Encode, BsbCodecTemperature );
+BENCHMARK_TEMPLATE( BM_Encode, BsbCodecPercentHalf );
+BENCHMARK_TEMPLATE( BM_Encode, BsbCodecWeekday );
+BENCHMARK_TEMPLATE( BM_Encode, BsbCodecEnum );
+BENCHMARK_TEMPLATE( BM_Encode, BsbCodecEnum16 );
+BENCHMARK_TEMPLATE( BM_Encode, BsbCodecRoomTemperature );
+
+// the text codecs render the payload as string
+template< typename Codec >
+static void BM_Format( benchmark::State& state ) {
+  const BsbPayload payload = { 0x01, 124, 10, 19, 1, 12, 30, 15, 0x00 };
+
+  for( auto _ : state ) {
+    benchmark::DoNotOptimize( Codec::format( payload ) );
+  }
+}
+BENCHMARK_TEMPLATE( BM_Format, BsbCodecDateTime );
+BENCHMARK_TEMPLATE( BM_Format, BsbCodecText );
+
+static void BM_FormatWeekday( benchmark::State& state ) {
+  const BsbPayload payload = make_payload< BsbCodecWeekday >( 3 );
+
+  for( auto _ : state ) {
+    benchmark::DoNotOptimize( BsbCodecWeekday::format( payload ) );
+  }
+}
+BENCHMARK( BM_FormatWeekday );
@@ -0,0 +1,69 @@
+#pragma once
+
+#include <cstdint>
+
+#include "bsb.h"
+#include "bsbNumber.h"
+#include "bsbSensor.h"
+#include "esphome/components/uart/uart.h"
+#include "esphome/core/hal.h"
+
+// The component on the host: with its own simulated UART and access to the internals the host programs measure. The
+// entities are created like the generated code of ESPHome does.
+
+namespace esphome {
+  namespace bsb {
+    class HostBsbComponent : public BsbComponent {
+    public:
+      HostBsbComponent() {
+        set_uart_parent( &uart_ );
+        set_source_address( 0x42 );
+        set_destination_address( 0x00 );
+        set_query_interval( 250 );
+        set_retry_interval( 15000 );
+        set_retry_count( 3 );
+      }
+
+      uart::UARTComponent& get_uart() { return uart_; }
+
+      // one pass of the main loop of ESPHome
+      void step() {
+        run_scheduler( millis() );
+        loop();
+      }
+
+      const BsbPacketReceive&   get_receiver() const { return bsbPacketReceive; }
+      const BsbAllocationStats& get_allocations_receive() const { return allocations_receive_; }
+      const BsbAllocationStats& get_allocations_send() const { return allocations_send_; }
+      const BsbAllocationStats& get_allocations_publish() const { return allocations_publish_; }
+      const BsbLoadGovernor&    get_governor() const { return governor_; }
+
+    private:
+      uart::UARTComponent uart_;
+    };
+
+    // any of the sensors, text sensors and binary sensors
+    template< typename Entity >
+    Entity* make_sensor( HostBsbComponent& component, const uint32_t field_id, const uint32_t update_interval ) {
+      auto* sensor = new Entity();
+      sensor->set_field_id( field_id );
+      sensor->set_update_interval( update_interval );
+      component.register_sensor( sensor );
+      sensor->set_retry_interval( component.get_retry_interval() );
+      sensor->set_retry_count( component.get_retry_count() );
+      return sensor;
+    }
+
+    // any of the numbers, switches and selects
+    template< typename Entity >
+    Entity* make_number( HostBsbComponent& component, const uint32_t field_id, const uint32_t update_interval ) {
+      auto* number = new Entity();
+      number->set_field_id( field_id );
+      number->set_update_interval( update_interval );
+      component.register_number( number );
+      number->set_retry_interval( component.get_retry_interval() );
+      number->set_retry_count( component.get_retry_count() );
+      return number;
+    }
+  }
+}
@@ -0,0 +1,85 @@
+// Scaling of the buses: every bus polls its own simulated controller as fast as its query interval allows, either with
+// a loop per bus or served by one BsbEngine (multi-bus mode). Per bus and simulated second, the throughput has to stay
+// the same with more buses, else the benchmark fails; the CPU time per transaction shows the cost of the scheduling.
+//
+//   cmake -S . -B build && cmake --build build && build/host/bsb_multibus_benchmark
+
+#include <benchmark/benchmark.h>
+
+#include <cstdint>
+#include <map>
+
+#include "bsb_simulation.h"
+
+using namespace esphome;
+using namespace esphome::bsb;
+
+namespace {
+  // more entities than a bus can poll, so every bus runs at its limit
+  constexpr uint32_t Sensors         = 16;
+  constexpr uint32_t UpdateInterval  = 1000;
+  constexpr uint64_t SimulatedPeriod = 60000;
+
+  void add_bus( Simulation& simulation ) {
+    SimulatedBus& bus = simulation.add_bus();
+    for( uint32_t i = 0; i < Sensors; ++i ) {
+      const uint32_t field_id = 0x0D3D0500 + i;
+      make_sensor< BsbSensorTyped< BsbCodecTemperature > >( bus.component, field_id, UpdateInterval );
+      bus.controller.add_field< BsbCodecTemperature >( field_id, 20.0f + i, 2.0f );
+    }
+  }
+
+  const uint64_t replies( Simulation& simulation ) {
+    uint64_t replies = 0;
+    for( size_t i = 0; i < simulation.size(); ++i ) {
+      replies += simulation.get_bus( i ).controller.get_replies();
+    }
+    return replies;
+  }
+}
+
+static void BM_MultiBus( benchmark::State& state ) {
+  // the throughput per bus of the first run with one bus, per mode
+  static std::map< int64_t, double > single_bus;
+
+  const int64_t buses  = state.range( 0 );
+  const bool    engine = state.range( 1 ) != 0;
+
+  host::set_time( 0 );
+  Simulation simulation;
+  for( int64_t i = 0; i < buses; ++i ) {
+    add_bus( simulation );
+  }
+  if( engine ) {
+    simulation.use_engine();
+  }
+  simulation.setup();
+  // past the start, when all entities are due at once
+  simulation.run_until( SimulatedPeriod );
+
+  const uint64_t start   = host::get_time() / 1000;
+  const uint64_t initial = replies( simulation );
+  for( auto _ : state ) {
+    simulation.run_until( host::get_time() / 1000 + SimulatedPeriod );
+  }
+  const uint64_t transactions = replies( simulation ) - initial;
+
+  const double seconds = double( host::get_time() / 1000 - start ) / 1000;
+  const double per_bus = transactions / seconds / buses;
+
+  state.counters["transactions/s/bus"] = per_bus;
+  state.counters["cpu/transaction"]    = benchmark::Counter( double( transactions ), benchmark::Counter::kIsRate | benchmark::Counter::kInvert );
+  if( engine ) {
+    state.counters["deferred"] = simulation.get_engine()->get_deferred();
+  }
+
+  if( buses == 1 ) {
+    single_bus[state.range( 1 )] = per_bus;
+  } else if( single_bus.count( state.range( 1 ) ) != 0 && per_bus < 0.95 * single_bus[state.range( 1 )] ) {
+    state.SkipWithError( "the throughput per bus dropped with more buses" );
+  }
+}
+BENCHMARK( BM_MultiBus )
+    ->ArgNames( { "buses", "engine" } )
+    ->ArgsProduct( { { 1, 2, 4, 8 }, { 0, 1 } } )
+    ->Unit( benchmark::kMillisecond );
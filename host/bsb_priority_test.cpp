@@ -0,0 +1,120 @@
+// The priorities of the entities: which entity polls a shared field, the order after a resync, the refreshes ahead of
+// the priorities and the rescheduling when the load shedding changes its level.
+
+#include <gtest/gtest.h>
+
+#include <cstdint>
+#include <vector>
+
+#include "bsb_simulation.h"
+
+using namespace esphome;
+using namespace esphome::bsb;
+
+TEST( BsbPriority, HighestPriorityPollsTheField ) {
+  host::set_time( 0 );
+  HostBsbComponent component;
+  auto*            sensor = make_sensor< BsbSensorTyped< BsbCodecTemperature > >( component, 0x2D3D058E, 60000 );
+  auto*            number = make_number< BsbNumberTyped< BsbCodecTemperature > >( component, 0x2D3D058E, 60000 );
+  sensor->set_priority( BsbPriority::Critical );
+  component.setup();
+
+  // the number would win on the same interval, but not against a higher priority
+  EXPECT_TRUE( sensor->is_polled() );
+  EXPECT_FALSE( number->is_polled() );
+}
+
+TEST( BsbPriority, NumberWinsWithinThePriority ) {
+  host::set_time( 0 );
+  HostBsbComponent component;
+  auto*            sensor = make_sensor< BsbSensorTyped< BsbCodecTemperature > >( component, 0x2D3D058E, 60000 );
+  auto*            number = make_number< BsbNumberTyped< BsbCodecTemperature > >( component, 0x2D3D058E, 60000 );
+  component.setup();
+
+  EXPECT_FALSE( sensor->is_polled() );
+  EXPECT_TRUE( number->is_polled() );
+}
+
+TEST( BsbPriority, ResyncPollsByPriority ) {
+  host::set_time( 0 );
+  Simulation    simulation;
+  SimulatedBus& bus = simulation.add_bus();
+
+  const BsbPriority priorities[] = { BsbPriority::Background, BsbPriority::Normal, BsbPriority::Critical };
+  for( uint32_t i = 0; i < 3; ++i ) {
+    auto* sensor = make_sensor< BsbSensorTyped< BsbCodecTemperature > >( bus.component, 0x0D3D0500 + i, 10000 );
+    sensor->set_priority( priorities[i] );
+    bus.controller.add_field< BsbCodecTemperature >( 0x0D3D0500 + i, 20.0f );
+  }
+  auto* number = make_number< BsbNumberTyped< BsbCodecTemperature > >( bus.component, 0x2D3D058E, 10000 );
+  number->set_priority( BsbPriority::Background );
+  bus.controller.add_field< BsbCodecTemperature >( 0x2D3D058E, 21.0f );
+
+  // the link goes down and recovers after the outage
+  bus.controller.add_outage( 30000, 120000 );
+  simulation.setup();
+  simulation.run_until( 120000 );
+  bus.controller.get_requested().clear();
+  simulation.run_until( 150000 );
+
+  // the probe, then all fields after the recovery
+  const std::vector< uint32_t >& requested = bus.controller.get_requested();
+  ASSERT_GE( requested.size(), 5u );
+  const std::vector< uint32_t > order( requested.begin() + 1, requested.begin() + 5 );
+  EXPECT_EQ( order, ( std::vector< uint32_t >{ 0x0D3D0502, 0x0D3D0501, 0x2D3D058E, 0x0D3D0500 } ) );
+}
+
+TEST( BsbPriority, GroupRefreshGoesAheadOfThePolls ) {
+  host::set_time( 0 );
+  Simulation    simulation;
+  SimulatedBus& bus = simulation.add_bus();
+
+  for( uint32_t i = 0; i < 8; ++i ) {
+    auto* sensor = make_sensor< BsbSensorTyped< BsbCodecTemperature > >( bus.component, 0x0D3D0500 + i, 60000 );
+    sensor->set_priority( BsbPriority::Critical );
+    bus.controller.add_field< BsbCodecTemperature >( 0x0D3D0500 + i, 20.0f );
+  }
+
+  BsbGroup group;
+  group.set_update_interval( 60000 );
+  group.set_priority( BsbPriority::Background );
+  bus.component.register_group( &group );
+  for( uint32_t i = 0; i < 2; ++i ) {
+    group.add_member( make_sensor< BsbSensorTyped< BsbCodecTemperature > >( bus.component, 0x0D3D0600 + i, 60000 ) );
+    bus.controller.add_field< BsbCodecTemperature >( 0x0D3D0600 + i, 30.0f );
+  }
+
+  sensor::Sensor latency;
+  bus.component.set_refresh_latency_sensor( &latency );
+
+  // at the start all critical fields are due, the refresh of the background group is served first anyway
+  simulation.setup();
+  bus.component.request_group_refresh( &group );
+  simulation.run_until( 10000 );
+
+  const std::vector< uint32_t >& requested = bus.controller.get_requested();
+  ASSERT_GE( requested.size(), 10u );
+  EXPECT_EQ( std::vector< uint32_t >( requested.begin(), requested.begin() + 2 ), ( std::vector< uint32_t >{ 0x0D3D0600, 0x0D3D0601 } ) );
+  // two Gets and their replies instead of waiting for the eight critical ones
+  ASSERT_TRUE( latency.has_state() );
+  EXPECT_LT( latency.state, 1000 );
+}
+
+TEST( BsbPriority, RescheduleMovesThePendingUpdate ) {
+  BsbSensorTyped< BsbCodecTemperature > sensor;
+  sensor.set_update_interval( 60000 );
+  sensor.set_retry_interval( 15000 );
+
+  // stretched by the load shedding, then back to the full rate
+  sensor.schedule_next_regular_update( 1000, 8 );
+  EXPECT_EQ( sensor.get_time_until_due( 1000 ), 8 * 60000u );
+  sensor.reschedule( 1 );
+  EXPECT_EQ( sensor.get_time_until_due( 1000 ), 60000u );
+  sensor.reschedule( 4 );
+  EXPECT_EQ( sensor.get_time_until_due( 1000 ), 4 * 60000u );
+
+  // a field which is due anyway stays due
+  sensor.reset_retries( 2000 );
+  sensor.reschedule( 4 );
+  EXPECT_EQ( sensor.get_time_until_due( 2000 ), 0u );
+}
@@ -0,0 +1,195 @@
+// Replays captures (see bsbCapture.h) through the receive path of the component: the bytes of every record go into the
+// simulated UART at the time of the record, BsbComponent::loop() reads them, BsbPacketReceive::loop() frames them and
+// callback_packet() decodes them into the entities. Prints one JSON object per capture:
+//
+//   frames               frames with a correct CRC, in the first pass
+//   rejected             frames dropped because of a wrong CRC, in the first pass
+//   published            values published by the entities, in the first pass
+//   frames_per_second    through the component
+//   ns_per_byte          through the component
+//   parser_ns_per_byte   through BsbPacketReceive alone
+//   allocations_per_frame
+//
+//   bsb_replay [--repeat N] [--expect-frames N] [--expect-rejected N] [--expect-published N] capture...
+//
+// With the expectations, the exit code is 1 if a capture doesn't match them.
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iterator>
+#include <vector>
+
+#include "bsbCapture.h"
+#include "bsb_host.h"
+
+using namespace esphome;
+using namespace esphome::bsb;
+
+namespace {
+  struct Options {
+    int  repeat             = 20;
+    long expected_frames    = -1;
+    long expected_rejected  = -1;
+    long expected_published = -1;
+  };
+
+  struct Result {
+    uint32_t frames    = 0;
+    uint32_t rejected  = 0;
+    uint32_t published = 0;
+
+    // over all passes
+    size_t   bytes          = 0;
+    uint32_t total_frames   = 0;
+    double   seconds        = 0;
+    double   parser_seconds = 0;
+    uint32_t allocations    = 0;
+  };
+
+  const double seconds_since( const std::chrono::steady_clock::time_point start ) {
+    return std::chrono::duration< double >( std::chrono::steady_clock::now() - start ).count();
+  }
+
+  // the entities of the fields in the corpus, see corpus/generate.py
+  void add_entities( HostBsbComponent& component, uint32_t& published ) {
+    static const BsbEnumEntry modes[] = { { 0, "Protection" }, { 1, "Automatic" }, { 3, "Comfort" } };
+
+    auto count = [&published]( auto ) { ++published; };
+
+    make_sensor< BsbSensorTyped< BsbCodecTemperature > >( component, 0x0D3D0519, 60000 )->add_on_state_callback( count );
+    make_sensor< BsbSensorTyped< BsbCodecTemperature > >( component, 0x313D052F, 60000 )->add_on_state_callback( count );
+    make_sensor< BsbSensorTyped< BsbCodecPercentHalf > >( component, 0x053D0F66, 60000 )->add_on_state_callback( count );
+    make_sensor< BsbSensorTyped< BsbCodecUInt16 > >( component, 0x053D0064, 60000 )->add_on_state_callback( count );
+    make_sensor< BsbSensorTyped< BsbCodecInt32 > >( component, 0x193D2FBF, 60000 )->add_on_state_callback( count );
+    make_sensor< BsbSensorTyped< BsbCodecTemperature > >( component, 0x0500021F, 60000 )->add_on_state_callback( count );
+    make_sensor< BsbSensorTyped< BsbCodecRoomTemperature > >( component, 0x2D3D0215, 60000 )->add_on_state_callback( count );
+    make_sensor< BsbTextSensorTyped< BsbCodecDateTime > >( component, 0x0500006B, 60000 )->add_on_state_callback( count );
+
+    auto* mode = make_sensor< BsbEnumTextSensor< BsbCodecEnum > >( component, 0x2D3D0211, 60000 );
+    mode->set_enum_table( modes, sizeof( modes ) / sizeof( modes[0] ) );
+    mode->add_on_state_callback( count );
+
+    make_number< BsbNumberTyped< BsbCodecTemperature > >( component, 0x2D3D058E, 60000 )->add_on_state_callback( count );
+  }
+
+  const bool replay( const std::vector< uint8_t >& capture, const Options& options, Result& result ) {
+    // the parser alone
+    {
+      BsbPacketReceive receive( []( const BsbPacket* ) {} );
+
+      const auto start = std::chrono::steady_clock::now();
+      for( int pass = 0; pass < options.repeat; ++pass ) {
+        if( BsbCapture::replay( capture, receive ) < 0 ) {
+          return false;
+        }
+      }
+      result.parser_seconds = seconds_since( start );
+    }
+
+    // the component, passive so it only listens like during the recording
+    host::set_time( 0 );
+    HostBsbComponent component;
+    component.set_passive( true );
+    uint32_t published = 0;
+    add_entities( component, published );
+    component.setup();
+
+    uint32_t duration = 0;
+    BsbCapture::for_each_record( capture, [&duration]( const uint32_t timestamp, const uint8_t*, const uint8_t ) { duration = timestamp; } );
+
+    const uint32_t allocations = BsbAllocationCounters::allocations;
+    const auto     start       = std::chrono::steady_clock::now();
+    for( int pass = 0; pass < options.repeat; ++pass ) {
+      // every pass continues where the last one stopped
+      const uint64_t offset = uint64_t( pass ) * ( duration + 1000 );
+
+      BsbCapture::for_each_record( capture, [&]( const uint32_t timestamp, const uint8_t* data, const uint8_t length ) {
+        host::set_time( ( offset + timestamp ) * 1000 );
+        component.get_uart().inject( data, length );
+        component.step();
+        result.bytes += length;
+      } );
+
+      // the counts of the first pass, the later ones start with the state the previous one left behind
+      if( pass == 0 ) {
+        result.frames    = component.get_receiver().get_frames();
+        result.rejected  = component.get_receiver().get_crc_errors();
+        result.published = published;
+      }
+    }
+    result.seconds      = seconds_since( start );
+    result.allocations  = BsbAllocationCounters::allocations - allocations;
+    result.total_frames = component.get_receiver().get_frames();
+    return true;
+  }
+
+  const bool matches( const char* name, const long expected, const uint32_t actual ) {
+    if( expected >= 0 && expected != long( actual ) ) {
+      fprintf( stderr, "%s: expected %ld, got %u\n", name, expected, actual );
+      return false;
+    }
+    return true;
+  }
+}
+
+int main( int argc, char** argv ) {
+  Options             options;
+  std::vector< char* > captures;
+
+  for( int i = 1; i < argc; ++i ) {
+    if( i + 1 < argc && strcmp( argv[i], "--repeat" ) == 0 ) {
+      options.repeat = std::max( atoi( argv[++i] ), 1 );
+    } else if( i + 1 < argc && strcmp( argv[i], "--expect-frames" ) == 0 ) {
+      options.expected_frames = atol( argv[++i] );
+    } else if( i + 1 < argc && strcmp( argv[i], "--expect-rejected" ) == 0 ) {
+      options.expected_rejected = atol( argv[++i] );
+    } else if( i + 1 < argc && strcmp( argv[i], "--expect-published" ) == 0 ) {
+      options.expected_published = atol( argv[++i] );
+    } else {
+      captures.push_back( argv[i] );
+    }
+  }
+
+  if( captures.empty() ) {
+    fprintf( stderr, "usage: %s [--repeat N] [--expect-frames N] [--expect-rejected N] [--expect-published N] capture...\n", argv[0] );
+    return 2;
+  }
+
+  bool ok = true;
+  for( const char* path : captures ) {
+    std::ifstream file( path, std::ios::binary );
+    if( !file ) {
+      fprintf( stderr, "%s: can't be read\n", path );
+      return 2;
+    }
+    const std::vector< uint8_t > capture( ( std::istreambuf_iterator< char >( file ) ), std::istreambuf_iterator< char >() );
+
+    Result result;
+    if( !replay( capture, options, result ) ) {
+      fprintf( stderr, "%s: not a valid capture\n", path );
+      return 2;
+    }
+
+    printf( "{\"capture\": \"%s\", \"bytes\": %zu, \"frames\": %u, \"rejected\": %u, \"published\": %u, "
+            "\"frames_per_second\": %.0f, \"ns_per_byte\": %.1f, \"parser_ns_per_byte\": %.1f, \"allocations_per_frame\": %.3f}\n",
+            path,
+            result.bytes / options.repeat,
+            result.frames,
+            result.rejected,
+            result.published,
+            result.total_frames / result.seconds,
+            result.seconds * 1e9 / result.bytes,
+            result.parser_seconds * 1e9 / result.bytes,
+            result.total_frames != 0 ? double( result.allocations ) / result.total_frames : 0.0 );
+
+    ok = matches( "frames", options.expected_frames, result.frames ) && ok;
+    ok = matches( "rejected", options.expected_rejected, result.rejected ) && ok;
+    ok = matches( "published", options.expected_published, result.published ) && ok;
+  }
+
+  return ok ? 0 : 1;
+}
@@ -0,0 +1,111 @@
+// The runtime tuning of the fields, see the actions in automation.h, and the refreshes.
+
+#include <gtest/gtest.h>
+
+#include <cstdint>
+
+#include "bsb_simulation.h"
+
+using namespace esphome;
+using namespace esphome::bsb;
+
+namespace {
+  constexpr uint32_t FieldId = 0x0D3D0519;
+}
+
+TEST( BsbRuntime, ResumedFieldIsPolledRightAway ) {
+  host::set_time( 0 );
+  Simulation    simulation;
+  SimulatedBus& bus = simulation.add_bus();
+  make_sensor< BsbSensorTyped< BsbCodecTemperature > >( bus.component, FieldId, 15 * 60 * 1000 );
+  bus.controller.add_field< BsbCodecTemperature >( FieldId, 21.0f );
+
+  simulation.setup();
+  simulation.run_until( 60000 );
+  ASSERT_EQ( bus.controller.get_gets(), 1u );
+
+  bus.component.set_field_paused( FieldId, true );
+  simulation.run_until( 5 * 60 * 1000 );
+  EXPECT_EQ( bus.controller.get_gets(), 1u );
+
+  // long before the next regular update and without a new interval, the field is due at once all the same
+  bus.component.set_field_paused( FieldId, false );
+  simulation.run_until( 5 * 60 * 1000 + 2000 );
+  EXPECT_EQ( bus.controller.get_gets(), 2u );
+}
+
+TEST( BsbRuntime, ChangedIntervalCountsFromNow ) {
+  host::set_time( 0 );
+  Simulation    simulation;
+  SimulatedBus& bus = simulation.add_bus();
+  make_sensor< BsbSensorTyped< BsbCodecTemperature > >( bus.component, FieldId, 15 * 60 * 1000 );
+  bus.controller.add_field< BsbCodecTemperature >( FieldId, 21.0f );
+
+  simulation.setup();
+  simulation.run_until( 60000 );
+
+  bus.component.set_field_update_interval( FieldId, 10000 );
+  simulation.run_until( 62000 );
+  EXPECT_EQ( bus.controller.get_gets(), 2u );
+  simulation.run_until( 62000 + 60000 );
+  EXPECT_EQ( bus.controller.get_gets(), 8u );
+}
+
+TEST( BsbRuntime, RefreshLatencyEndsWithThePublish ) {
+  host::set_time( 0 );
+  Simulation    simulation;
+  SimulatedBus& bus    = simulation.add_bus();
+  auto*         sensor = make_sensor< BsbSensorTyped< BsbCodecTemperature > >( bus.component, FieldId, 15 * 60 * 1000 );
+  bus.controller.add_field< BsbCodecTemperature >( FieldId, 21.0f );
+  sensor::Sensor latency;
+  bus.component.set_refresh_latency_sensor( &latency );
+
+  simulation.setup();
+  simulation.run_until( 60000 );
+
+  // a slow publish, pe to a busy API connection
+  sensor->add_on_state_callback( []( float ) { host::advance_time( 30 * 1000 ); } );
+  bus.component.request_refresh( FieldId );
+  simulation.run_until( 62000 );
+
+  ASSERT_TRUE( latency.has_state() );
+  // the reply latency of the controller and the publish
+  EXPECT_GE( latency.state, 40 + 30 );
+}
+
+TEST( BsbRuntime, ResyncRecordsNoRefreshLatency ) {
+  host::set_time( 0 );
+  Simulation    simulation;
+  SimulatedBus& bus = simulation.add_bus();
+  make_sensor< BsbSensorTyped< BsbCodecTemperature > >( bus.component, FieldId, 60000 );
+  bus.controller.add_field< BsbCodecTemperature >( FieldId, 21.0f );
+
+  BsbGroup group;
+  group.set_update_interval( 15 * 60 * 1000 );
+  bus.component.register_group( &group );
+  auto* member = make_sensor< BsbSensorTyped< BsbCodecTemperature > >( bus.component, 0x0D3D0600, 60000 );
+  group.add_member( member );
+  bus.controller.add_field< BsbCodecTemperature >( 0x0D3D0600, 30.0f );
+
+  sensor::Sensor latency;
+  bus.component.set_refresh_latency_sensor( &latency );
+  uint32_t publishes = 0;
+  member->add_on_state_callback( [&publishes]( float ) { ++publishes; } );
+
+  // the link goes down and recovers after the outage, the resync sweeps the group long before its interval
+  bus.controller.add_outage( 30000, 120000 );
+  simulation.setup();
+  simulation.run_until( 60000 );
+  ASSERT_EQ( publishes, 1u );
+  simulation.run_until( 150000 );
+
+  EXPECT_EQ( publishes, 2u );
+  EXPECT_FALSE( latency.has_state() );
+
+  // a refresh afterwards is still measured from its own request
+  bus.component.request_group_refresh( &group );
+  simulation.run_until( 160000 );
+  EXPECT_EQ( publishes, 3u );
+  ASSERT_TRUE( latency.has_state() );
+  EXPECT_LT( latency.state, 1000 );
+}
@@ -0,0 +1,67 @@
+// The deadlines of bsbScheduling.h across the overflow of millis() after 49.7 days, and the update_interval never.
+
+#include <gtest/gtest.h>
+
+#include <cstdint>
+
+#include "bsbScheduling.h"
+#include "bsb_simulation.h"
+
+using namespace esphome;
+using namespace esphome::bsb;
+
+TEST( BsbScheduling, DeadlinePassedAcrossTheWrap ) {
+  // a deadline after the overflow, seen from before it
+  EXPECT_FALSE( bsb_deadline_passed( UINT32_MAX - 500, 500 ) );
+  EXPECT_FALSE( bsb_deadline_passed( UINT32_MAX, 0 ) );
+  EXPECT_TRUE( bsb_deadline_passed( 0, 0 ) );
+  EXPECT_TRUE( bsb_deadline_passed( 501, 500 ) );
+
+  // a deadline before the overflow, seen from after it
+  EXPECT_TRUE( bsb_deadline_passed( 500, UINT32_MAX - 500 ) );
+  EXPECT_TRUE( bsb_deadline_passed( 0, UINT32_MAX ) );
+
+  // the same without an overflow
+  EXPECT_TRUE( bsb_deadline_passed( 1000, 1000 ) );
+  EXPECT_FALSE( bsb_deadline_passed( 999, 1000 ) );
+}
+
+TEST( BsbScheduling, DeadlineUpToHalfTheRange ) {
+  const uint32_t now = UINT32_MAX - 1000;
+  EXPECT_FALSE( bsb_deadline_passed( now, now + BsbMaxInterval ) );
+  EXPECT_TRUE( bsb_deadline_passed( now + BsbMaxInterval, now + BsbMaxInterval ) );
+}
+
+TEST( BsbScheduling, TimeUntilAcrossTheWrap ) {
+  EXPECT_EQ( bsb_time_until( UINT32_MAX - 499, 500 ), 1000u );
+  EXPECT_EQ( bsb_time_until( 500, UINT32_MAX - 499 ), 0u );
+  EXPECT_EQ( bsb_time_until_elapsed( 500, UINT32_MAX - 499, 2000 ), 1000u );
+  EXPECT_EQ( bsb_time_until_elapsed( 1500, UINT32_MAX - 499, 2000 ), 0u );
+}
+
+TEST( BsbScheduling, NeverStaysNever ) {
+  EXPECT_EQ( bsb_scaled_interval( SCHEDULER_DONT_RUN, 1 ), BsbNever );
+  EXPECT_EQ( bsb_scaled_interval( SCHEDULER_DONT_RUN, 4 ), BsbNever );
+  EXPECT_EQ( bsb_scaled_interval( uint32_t( INT32_MAX ) + 1, 1 ), BsbMaxInterval );
+  EXPECT_EQ( bsb_scaled_interval( 60000, 16 ), 960000u );
+}
+
+TEST( BsbScheduling, FieldWithNeverIsReadOnce ) {
+  constexpr uint32_t FieldId = 0x0D3D0519;
+
+  host::set_time( 0 );
+  Simulation    simulation;
+  SimulatedBus& bus = simulation.add_bus();
+  make_sensor< BsbSensorTyped< BsbCodecTemperature > >( bus.component, FieldId, SCHEDULER_DONT_RUN );
+  bus.controller.add_field< BsbCodecTemperature >( FieldId, 21.0f );
+
+  simulation.setup();
+  // past the 24.8 days an interval capped to the deadlines would last
+  simulation.run_until( uint64_t( 30 ) * 24 * 60 * 60 * 1000 );
+  EXPECT_EQ( bus.controller.get_gets(), 1u );
+
+  // still read on request
+  bus.component.request_refresh( FieldId );
+  simulation.run_until( uint64_t( 30 ) * 24 * 60 * 60 * 1000 + 2000 );
+  EXPECT_EQ( bus.controller.get_gets(), 2u );
+}
@@ -0,0 +1,243 @@
+#pragma once
+
+#include <algorithm>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <random>
+#include <unordered_map>
+#include <vector>
+
+#include "bsbEngine.h"
+#include "bsbPacketReceive.h"
+#include "bsb_host.h"
+
+// The heating system on the simulated bus of a HostBsbComponent, and a simulation which runs buses against their
+// controllers from event to event of the simulated clock, so days of operation take seconds.
+
+namespace esphome {
+  namespace bsb {
+    class SimulatedController {
+    public:
+      // the payload of a field at the simulated time, in ms
+      using Value = std::function< void( BsbPayload& payload, const uint64_t now ) >;
+
+      explicit SimulatedController( HostBsbComponent& component )
+          : component_( component ), receive_( [this]( const BsbPacket* packet ) { received( packet ); } ) {}
+
+      // a field with the payload of the codec, the value climbs by the amplitude within 8 minutes and starts over
+      template< typename Codec >
+      void add_field( const uint32_t field_id, const float value, const float amplitude = 0 ) {
+        fields_[field_id] = [value, amplitude]( BsbPayload& payload, const uint64_t now ) {
+          Codec::encode_set( payload, value + amplitude * float( ( now / 60000 ) % 8 ) / 8, 0x01 );
+        };
+      }
+
+      // a field which is answered with a Nack, pe because it is read only
+      void add_read_only( const uint32_t field_id ) { read_only_.push_back( field_id ); }
+
+      // the time from the end of a request to the reply, in ms
+      void set_latency( const uint32_t val ) { latency_ = val; }
+      void set_seed( const uint32_t val ) { random_.seed( val ); }
+      // share of the requests without reply and of the replies with a garbled byte
+      void set_loss( const double val ) { loss_ = val; }
+      void set_corruption( const double val ) { corruption_ = val; }
+      // the controller doesn't answer in [start, end), in ms of the simulated time
+      void add_outage( const uint64_t start, const uint64_t end ) { outages_.push_back( { start, end } ); }
+      const bool in_outage( const uint64_t now ) const {
+        return std::any_of(
+          outages_.cbegin(), outages_.cend(), [now]( const Outage& outage ) { return now >= outage.start && now < outage.end; } );
+      }
+
+      // takes the frames the component sent and echoes them like the shared line does, then sends the due replies
+      void poll() {
+        const uint64_t now = host::get_time() / 1000;
+
+        size_t length;
+        while( ( length = component_.get_uart().take( chunk_, sizeof( chunk_ ) ) ) != 0 ) {
+          component_.get_uart().inject( chunk_, length );
+          for( size_t i = 0; i < length; ++i ) {
+            receive_.loop( chunk_[i] ^ 0xff );
+          }
+        }
+
+        while( !pending_.empty() && pending_.front().due <= now ) {
+          component_.get_uart().inject( pending_.front().frame.data(), pending_.front().frame.size() );
+          pending_.erase( pending_.begin() );
+          ++replies_;
+        }
+      }
+
+      // ms until the next reply is due, UINT32_MAX without any
+      const uint32_t get_time_until_event() const {
+        if( pending_.empty() ) {
+          return UINT32_MAX;
+        }
+        return uint32_t( std::max< int64_t >( int64_t( pending_.front().due ) - int64_t( host::get_time() / 1000 ), 0 ) );
+      }
+
+      const uint32_t get_gets() const { return gets_; }
+      const uint32_t get_sets() const { return sets_; }
+      const uint32_t get_replies() const { return replies_; }
+      // the field IDs of the Gets, in their order
+      std::vector< uint32_t >& get_requested() { return requested_; }
+
+    protected:
+      void received( const BsbPacket* packet ) {
+        if( packet->sourceAddress != SourceAddress || packet->destinationAddress != ControllerAddress ) {
+          return;
+        }
+
+        const uint64_t now = host::get_time() / 1000;
+        // the first two bytes of the field ID are swapped in the requests
+        const uint32_t field_id =
+          ( ( packet->fieldId & 0x00FF0000 ) << 8 ) | ( ( packet->fieldId >> 8 ) & 0x00FF0000 ) | ( packet->fieldId & 0xFFFF );
+
+        if( packet->command == BsbPacket::Command::Get ) {
+          ++gets_;
+          requested_.push_back( field_id );
+        } else if( packet->command == BsbPacket::Command::Set ) {
+          ++sets_;
+        } else {
+          return;
+        }
+
+        if( in_outage( now ) || uniform_( random_ ) < loss_ ) {
+          return;
+        }
+
+        BsbPacket reply;
+        reply.sourceAddress      = ControllerAddress;
+        reply.destinationAddress = SourceAddress;
+        reply.fieldId            = field_id;
+
+        const auto field = fields_.find( field_id );
+        if( field == fields_.end() ) {
+          return;
+        }
+        if( packet->command == BsbPacket::Command::Set ) {
+          const bool read_only = std::find( read_only_.cbegin(), read_only_.cend(), field_id ) != read_only_.cend();
+          reply.command        = read_only ? BsbPacket::Command::Nack : BsbPacket::Command::Ack;
+          if( !read_only ) {
+            const BsbPayload value = packet->payload;
+            field->second          = [value]( BsbPayload& payload, const uint64_t ) { payload = value; };
+          }
+        } else {
+          reply.command = BsbPacket::Command::Ret;
+          field->second( reply.payload, now );
+        }
+        reply.create_packet();
+
+        std::vector< uint8_t > frame( reply.buffer );
+        for( uint8_t& data : frame ) {
+          data ^= 0xff;
+        }
+        if( uniform_( random_ ) < corruption_ ) {
+          frame[frame.size() / 2] ^= 0x10;
+        }
+        pending_.push_back( { now + latency_, std::move( frame ) } );
+      }
+
+      struct Pending {
+        uint64_t               due;
+        std::vector< uint8_t > frame;
+      };
+      struct Outage {
+        uint64_t start;
+        uint64_t end;
+      };
+
+      HostBsbComponent&                     component_;
+      BsbPacketReceive                      receive_;
+      std::unordered_map< uint32_t, Value > fields_;
+      std::vector< uint32_t >               read_only_;
+      std::vector< uint32_t >               requested_;
+      std::vector< Pending >                pending_;
+      std::vector< Outage >                 outages_;
+      uint8_t                               chunk_[64];
+      uint32_t                              latency_ = 40;
+      double                                loss_       = 0;
+      double                                corruption_ = 0;
+      std::mt19937                          random_{ 1 };
+      std::uniform_real_distribution<>      uniform_{ 0, 1 };
+      uint32_t                              gets_    = 0;
+      uint32_t                              sets_    = 0;
+      uint32_t                              replies_ = 0;
+
+      // the defaults of HostBsbComponent
+      static constexpr uint8_t SourceAddress     = 0x42;
+      static constexpr uint8_t ControllerAddress = 0x00;
+    };
+
+    struct SimulatedBus {
+      HostBsbComponent    component;
+      SimulatedController controller{ component };
+    };
+
+    class Simulation {
+    public:
+      SimulatedBus& add_bus() {
+        buses_.emplace_back( new SimulatedBus() );
+        return *buses_.back();
+      }
+      SimulatedBus& get_bus( const size_t index ) { return *buses_[index]; }
+      const size_t  size() const { return buses_.size(); }
+
+      // multi-bus mode: one engine serves all buses added so far
+      void use_engine() {
+        engine_.reset( new BsbEngine() );
+        for( auto& bus : buses_ ) {
+          engine_->register_bus( &bus->component );
+        }
+      }
+      BsbEngine* get_engine() { return engine_.get(); }
+
+      void setup() {
+        for( auto& bus : buses_ ) {
+          bus->component.setup();
+        }
+        if( engine_ ) {
+          engine_->setup();
+        }
+      }
+
+      // one pass of the main loop of ESPHome, then the clock jumps to the next event, at most by max_step ms; returns
+      // the step in ms
+      const uint32_t step( const uint32_t max_step = 60000 ) {
+        const uint32_t now = millis();
+        for( auto& bus : buses_ ) {
+          bus->controller.poll();
+          bus->component.step();
+        }
+        if( engine_ ) {
+          engine_->run_scheduler( now );
+          engine_->loop();
+        }
+
+        uint32_t next = max_step;
+        for( auto& bus : buses_ ) {
+          bus->controller.poll();
+          next = std::min( { next,
+                             uint32_t( std::max( bus->component.get_slack( millis() ), int32_t( 0 ) ) ),
+                             bus->component.get_time_until_scheduled( millis() ),
+                             bus->controller.get_time_until_event() } );
+        }
+        // the main loop doesn't run more often than every ms
+        next = std::max< uint32_t >( next, 1 );
+        host::advance_time( uint64_t( next ) * 1000 );
+        return next;
+      }
+
+      // runs until the simulated time, in ms since the start
+      void run_until( const uint64_t end ) {
+        while( host::get_time() / 1000 < end ) {
+          step( uint32_t( std::min< uint64_t >( end - host::get_time() / 1000, 60000 ) ) );
+        }
+      }
+
+    private:
+      std::vector< std::unique_ptr< SimulatedBus > > buses_;
+      std::unique_ptr< BsbEngine >                   engine_;
+    };
+  }
+}
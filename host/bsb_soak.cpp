@@ -0,0 +1,348 @@
+// Soak test: a bus with entities of every priority, a group, a number which is set every day and a broadcast, against a
+// simulated heating system which loses and garbles some replies and goes silent from time to time. The clock is
+// simulated and jumps from event to event, so two months take a few seconds; they cross the overflow of millis() after
+// 49.7 days. Writes a JSON report:
+//
+//   staleness            age of the published values, sampled every minute, per priority: p50, p95, p99, max in s
+//   heap                 bytes in use (mallinfo2) after the warm-up, at the end and at most, the allocations of the
+//                        process and the ones of the receive, send and publish paths of the component
+//   transactions         Gets and Sets per simulated second, replies and lost replies
+//   recovery             per outage, the time from its end to the link being up and to every entity published again
+//
+//   bsb_soak [--days N] [--start-days N] [--seed N] [--report file]
+//
+// The exit code is 1 if a check fails: a critical value older than 3 of its intervals outside the outages, the heap
+// growing by more than 64 KiB, or an outage without full recovery within 10 minutes.
+
+#include <algorithm>
+#include <array>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <vector>
+#ifdef __GLIBC__
+  #include <malloc.h>
+#endif
+
+#include "bsb_simulation.h"
+
+using namespace esphome;
+using namespace esphome::bsb;
+
+namespace {
+  constexpr uint64_t Minute = 60 * 1000;
+  constexpr uint64_t Hour   = 60 * Minute;
+  constexpr uint64_t Day    = 24 * Hour;
+  // millis() overflows after 2^32 ms
+  constexpr uint64_t Wrap = uint64_t( UINT32_MAX ) + 1;
+
+  constexpr uint64_t WarmUp          = Hour;
+  constexpr uint64_t OutageEvery     = 4 * Day;
+  constexpr uint64_t OutageDuration  = 15 * Minute;
+  constexpr uint64_t RecoveryLimit   = 10 * Minute;
+  constexpr double   StalenessLimit  = 3;
+  constexpr size_t   HeapGrowthLimit = 64 * 1024;
+
+  struct Options {
+    double      days       = 61;
+    double      start_days = 0;
+    uint32_t    seed       = 1;
+    const char* report     = nullptr;
+  };
+
+  // ages in s, the last bin takes the rest; fixed, so the sampling doesn't grow the heap it measures
+  class Histogram {
+  public:
+    void add( const uint64_t age_ms ) {
+      ++bins_[std::min< uint64_t >( age_ms / 1000, Bins - 1 )];
+      ++count_;
+      max_ = std::max( max_, age_ms );
+    }
+
+    const double percentile( const double share ) const {
+      const uint64_t rank = uint64_t( share * ( count_ - 1 ) );
+      uint64_t       seen = 0;
+      for( size_t i = 0; i < Bins; ++i ) {
+        seen += bins_[i];
+        if( seen > rank ) {
+          return double( i );
+        }
+      }
+      return double( Bins - 1 );
+    }
+    const double   max() const { return max_ / 1000.0; }
+    const uint64_t count() const { return count_; }
+
+  private:
+    static constexpr size_t         Bins = 4 * 60 * 60;
+    std::array< uint64_t, Bins > bins_{};
+    uint64_t                        count_ = 0;
+    uint64_t                        max_   = 0;
+  };
+
+  struct Entity {
+    uint32_t    interval;
+    BsbPriority priority;
+    uint64_t    published = 0;
+  };
+
+  struct Outage {
+    uint64_t start;
+    uint64_t end;
+    uint64_t link_up   = 0;
+    uint64_t refreshed = 0;
+  };
+
+  const uint64_t now_ms() { return host::get_time() / 1000; }
+
+  const size_t heap_in_use() {
+#ifdef __GLIBC__
+    return mallinfo2().uordblks;
+#else
+    return 0;
+#endif
+  }
+
+  const bool in_outage( const std::vector< Outage >& outages, const uint64_t time, const uint64_t margin ) {
+    return std::any_of( outages.cbegin(), outages.cend(), [time, margin]( const Outage& outage ) {
+      return time >= outage.start && time < outage.end + margin;
+    } );
+  }
+}
+
+int main( int argc, char** argv ) {
+  Options options;
+  for( int i = 1; i + 1 < argc; i += 2 ) {
+    if( strcmp( argv[i], "--days" ) == 0 ) {
+      options.days = atof( argv[i + 1] );
+    } else if( strcmp( argv[i], "--start-days" ) == 0 ) {
+      options.start_days = atof( argv[i + 1] );
+    } else if( strcmp( argv[i], "--seed" ) == 0 ) {
+      options.seed = uint32_t( atoi( argv[i + 1] ) );
+    } else if( strcmp( argv[i], "--report" ) == 0 ) {
+      options.report = argv[i + 1];
+    } else {
+      fprintf( stderr, "usage: %s [--days N] [--start-days N] [--seed N] [--report file]\n", argv[0] );
+      return 2;
+    }
+  }
+
+  const uint64_t start = uint64_t( options.start_days * Day );
+  const uint64_t end   = start + uint64_t( options.days * Day );
+  host::set_time( start * 1000 );
+
+  Simulation          simulation;
+  SimulatedBus&       bus = simulation.add_bus();
+  std::vector< Entity > entities;
+  entities.reserve( 32 );
+
+  auto track = [&entities]( auto* entity, const uint32_t interval, const BsbPriority priority ) {
+    entities.push_back( { interval, priority } );
+    const size_t index = entities.size() - 1;
+    entity->add_on_state_callback( [&entities, index]( auto ) { entities[index].published = now_ms(); } );
+  };
+
+  auto add_sensor = [&]( const uint32_t field_id, const uint32_t interval, const BsbPriority priority ) {
+    auto* sensor = make_sensor< BsbSensorTyped< BsbCodecTemperature > >( bus.component, field_id, interval );
+    sensor->set_priority( priority );
+    bus.controller.add_field< BsbCodecTemperature >( field_id, 20.0f, 5.0f );
+    track( sensor, interval, priority );
+    return sensor;
+  };
+
+  for( uint32_t i = 0; i < 4; ++i ) {
+    add_sensor( 0x0D3D0500 + i, 30000, BsbPriority::Critical );
+  }
+  for( uint32_t i = 0; i < 6; ++i ) {
+    add_sensor( 0x0D3D0600 + i, 2 * 60000, BsbPriority::Normal );
+  }
+  for( uint32_t i = 0; i < 6; ++i ) {
+    add_sensor( 0x0D3D0700 + i, 10 * 60000, BsbPriority::Background );
+  }
+
+  BsbGroup group;
+  group.set_update_interval( 5 * 60000 );
+  bus.component.register_group( &group );
+  for( uint32_t i = 0; i < 3; ++i ) {
+    group.add_member( add_sensor( 0x0D3D0800 + i, 5 * 60000, BsbPriority::Normal ) );
+  }
+
+  // only read at the start and on request
+  make_sensor< BsbSensorTyped< BsbCodecUInt16 > >( bus.component, 0x053D0064, SCHEDULER_DONT_RUN );
+  bus.controller.add_field< BsbCodecUInt16 >( 0x053D0064, 1234 );
+
+  auto* number = make_number< BsbNumberTyped< BsbCodecTemperature > >( bus.component, 0x2D3D058E, 5 * 60000 );
+  bus.controller.add_field< BsbCodecTemperature >( 0x2D3D058E, 21.0f );
+  track( number, 5 * 60000, BsbPriority::Normal );
+
+  auto* room = make_number< BsbNumberTyped< BsbCodecRoomTemperature > >( bus.component, 0x2D3D0215, SCHEDULER_DONT_RUN );
+  room->set_broadcast( true );
+  room->set_broadcast_interval( 60000 );
+  room->make_call( 21.5f );
+
+  binary_sensor::BinarySensor link;
+  bus.component.set_link_sensor( &link );
+  bus.component.set_load_shedding( 0.8f );
+
+  bus.controller.set_seed( options.seed );
+  bus.controller.set_loss( 0.01 );
+  bus.controller.set_corruption( 0.005 );
+
+  // regular outages, and one across the overflow of millis()
+  std::vector< Outage > outages;
+  for( uint64_t time = start + Day + Day / 2; time + OutageDuration < end; time += OutageEvery ) {
+    outages.push_back( { time, time + OutageDuration } );
+  }
+  if( start < Wrap && Wrap + OutageDuration < end ) {
+    outages.push_back( { Wrap - OutageDuration / 2, Wrap + OutageDuration / 2 } );
+  }
+  std::sort( outages.begin(), outages.end(), []( const Outage& a, const Outage& b ) { return a.start < b.start; } );
+  for( const Outage& outage : outages ) {
+    bus.controller.add_outage( outage.start, outage.end );
+  }
+
+  const auto wall_start = std::chrono::steady_clock::now();
+  simulation.setup();
+  simulation.run_until( start + WarmUp );
+
+  Histogram           staleness[3];
+  uint64_t            beyond_limit = 0;
+  const size_t        heap_start   = heap_in_use();
+  size_t              heap_max     = heap_start;
+  const uint32_t      allocations  = BsbAllocationCounters::allocations;
+  const uint32_t      receive      = bus.component.get_allocations_receive().allocations;
+  const uint32_t      send         = bus.component.get_allocations_send().allocations;
+  const uint32_t      publish      = bus.component.get_allocations_publish().allocations;
+  const uint32_t      gets         = bus.controller.get_gets();
+  const uint32_t      sets         = bus.controller.get_sets();
+  const uint32_t      replies      = bus.controller.get_replies();
+  const uint64_t      measured     = now_ms();
+  uint64_t            next_sample  = measured + Minute;
+  uint64_t            next_set     = measured + Day;
+  uint64_t            next_heap    = measured + Hour;
+  size_t              recovering   = 0;
+  float               setpoint     = 20.0f;
+
+  while( now_ms() < end ) {
+    const uint64_t now = now_ms();
+
+    if( now >= next_sample ) {
+      for( const Entity& entity : entities ) {
+        const uint64_t age = now - entity.published;
+        staleness[uint8_t( entity.priority )].add( age );
+        if( entity.priority == BsbPriority::Critical && age > StalenessLimit * entity.interval && !in_outage( outages, now, RecoveryLimit ) ) {
+          ++beyond_limit;
+        }
+      }
+      next_sample += Minute;
+    }
+
+    if( now >= next_set ) {
+      setpoint = setpoint == 20.0f ? 21.0f : 20.0f;
+      number->make_call( setpoint );
+      next_set += Day;
+    }
+
+    if( now >= next_heap ) {
+      heap_max = std::max( heap_max, heap_in_use() );
+      next_heap += Hour;
+    }
+
+    // the recovery from the outages, in their order
+    while( recovering < outages.size() && now >= outages[recovering].end ) {
+      Outage& outage = outages[recovering];
+      if( outage.link_up == 0 && link.state ) {
+        outage.link_up = now;
+      }
+      if( outage.refreshed == 0 &&
+          std::all_of( entities.cbegin(), entities.cend(), [&outage]( const Entity& entity ) { return entity.published >= outage.end; } ) ) {
+        outage.refreshed = now;
+      }
+      if( ( outage.link_up != 0 && outage.refreshed != 0 ) || now >= outage.end + 2 * RecoveryLimit ) {
+        ++recovering;
+      } else {
+        break;
+      }
+    }
+
+    simulation.step( uint32_t( std::min< uint64_t >( next_sample - now, 60000 ) ) );
+  }
+  const double wall = std::chrono::duration< double >( std::chrono::steady_clock::now() - wall_start ).count();
+
+  const size_t   heap_end = heap_in_use();
+  const double   seconds  = ( now_ms() - measured ) / 1000.0;
+  const uint32_t requests = bus.controller.get_gets() - gets + bus.controller.get_sets() - sets;
+
+  bool ok = beyond_limit == 0 && heap_end <= heap_start + HeapGrowthLimit;
+
+  FILE* report = options.report != nullptr ? fopen( options.report, "w" ) : stdout;
+  if( report == nullptr ) {
+    fprintf( stderr, "%s: can't be written\n", options.report );
+    return 2;
+  }
+
+  fprintf( report, "{\n" );
+  fprintf( report,
+           "  \"simulated_days\": %.2f, \"start_days\": %.2f, \"millis_wrapped\": %s, \"wall_seconds\": %.2f, \"speedup\": %.0f,\n",
+           options.days,
+           options.start_days,
+           ( start < Wrap && end > Wrap ) ? "true" : "false",
+           wall,
+           options.days * Day / 1000.0 / wall );
+
+  fprintf( report, "  \"staleness\": {" );
+  static const char* const names[] = { "critical", "normal", "background" };
+  for( int i = 0; i < 3; ++i ) {
+    fprintf( report,
+             "%s\n    \"%s\": {\"samples\": %llu, \"p50\": %.0f, \"p95\": %.0f, \"p99\": %.0f, \"max\": %.1f}",
+             i == 0 ? "" : ",",
+             names[i],
+             ( unsigned long long )staleness[i].count(),
+             staleness[i].percentile( 0.50 ),
+             staleness[i].percentile( 0.95 ),
+             staleness[i].percentile( 0.99 ),
+             staleness[i].max() );
+  }
+  fprintf( report, ",\n    \"critical_beyond_limit\": %llu\n  },\n", ( unsigned long long )beyond_limit );
+
+  fprintf( report,
+           "  \"heap\": {\"start\": %zu, \"end\": %zu, \"max\": %zu, \"growth\": %lld, \"process_allocations\": %u, "
+           "\"allocations_receive\": %u, \"allocations_send\": %u, \"allocations_publish\": %u},\n",
+           heap_start,
+           heap_end,
+           std::max( heap_max, heap_end ),
+           ( long long )heap_end - ( long long )heap_start,
+           uint32_t( BsbAllocationCounters::allocations - allocations ),
+           bus.component.get_allocations_receive().allocations - receive,
+           bus.component.get_allocations_send().allocations - send,
+           bus.component.get_allocations_publish().allocations - publish );
+
+  fprintf( report,
+           "  \"transactions\": {\"per_second\": %.3f, \"gets\": %u, \"sets\": %u, \"replies\": %u, \"crc_errors\": %u},\n",
+           requests / seconds,
+           bus.controller.get_gets() - gets,
+           bus.controller.get_sets() - sets,
+           bus.controller.get_replies() - replies,
+           bus.component.get_receiver().get_crc_errors() );
+
+  fprintf( report, "  \"recovery\": [" );
+  for( size_t i = 0; i < outages.size(); ++i ) {
+    const Outage& outage    = outages[i];
+    const bool    recovered = outage.link_up != 0 && outage.refreshed != 0 && outage.refreshed - outage.end <= RecoveryLimit;
+    ok                      = ok && recovered;
+    fprintf( report,
+             "%s\n    {\"start_days\": %.3f, \"link_up_ms\": %lld, \"refreshed_ms\": %lld, \"recovered\": %s}",
+             i == 0 ? "" : ",",
+             outage.start / double( Day ),
+             outage.link_up != 0 ? ( long long )( outage.link_up - outage.end ) : -1LL,
+             outage.refreshed != 0 ? ( long long )( outage.refreshed - outage.end ) : -1LL,
+             recovered ? "true" : "false" );
+  }
+  fprintf( report, "\n  ],\n  \"ok\": %s\n}\n", ok ? "true" : "false" );
+
+  if( report != stdout ) {
+    fclose( report );
+  }
+  return ok ? 0 : 1;
+}
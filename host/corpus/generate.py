@@ -0,0 +1,161 @@
+#!/usr/bin/env python3
+"""Generates the replay corpus: captures in the format of bsbCapture.h with simulated traffic of a heating system.
+
+    clean.bsbc      polls of a controller, replies, INF telegrams of the heating system and a room unit, Sets
+    noisy.bsbc      the same traffic with line noise between the frames and flipped bits in some of them
+    truncated.bsbc  the same traffic with some frames cut off, pe by a reset of the sender
+    collided.bsbc   the same traffic with frames of another device sent on top of some of them
+
+The traffic is pseudo-random with a fixed seed, so the captures only change when this script does.
+"""
+
+import os
+import random
+import struct
+
+BYTE_MS = 11 * 1000 / 4800  # 8N1 plus parity at 4800 baud
+LOOP_MS = 16  # the UART is read once per loop of ESPHome
+CHUNK = 32  # and in chunks of at most 32 bytes
+DURATION_MS = 30 * 60 * 1000
+
+INF, SET, ACK, NACK, GET, RET = 2, 3, 4, 5, 6, 7
+CONTROLLER, HEATING, ROOM_UNIT, OTHER, BROADCAST = 0x42, 0x00, 0x06, 0x0A, 0x7F
+
+# field ID, payload
+POLLED = [
+    (0x0D3D0519, lambda r: temperature(r.uniform(30, 70))),  # boiler temperature
+    (0x313D052F, lambda r: temperature(r.uniform(40, 55))),  # DHW temperature
+    (0x2D3D0211, lambda r: [0x00, r.choice([0, 1, 3])]),  # operating mode
+    (0x053D0F66, lambda r: [0x00, r.randint(0, 200)]),  # modulation in 0.5%
+    (0x053D0064, lambda r: [0x00, 0x00, 0x5A]),  # device family
+    (0x193D2FBF, lambda r: [0x00] + list(struct.pack(">i", r.randint(0, 100000)))),  # burner hours
+]
+OUTSIDE_TEMPERATURE = 0x0500021F
+ROOM_TEMPERATURE = 0x2D3D0215
+DATE_TIME = 0x0500006B
+SETPOINT = 0x2D3D058E
+
+
+def crc(data):
+    value = 0
+    for byte in data:
+        value ^= byte << 8
+        for _ in range(8):
+            value = ((value << 1) ^ 0x1021) if value & 0x8000 else value << 1
+            value &= 0xFFFF
+    return value
+
+
+def frame(source, destination, command, field_id, payload=()):
+    data = [0xDC, source | 0x80, destination, 11 + len(payload), command] + list(field_id.to_bytes(4, "big")) + list(payload)
+    value = crc(data)
+    return data + [value >> 8, value & 0xFF]
+
+
+def temperature(value):
+    raw = int(value * 64) & 0xFFFF
+    return [0x00, raw >> 8, raw & 0xFF]
+
+
+def traffic(rng):
+    """Yields (start in ms, frame) of the undisturbed traffic, in order."""
+    events = []
+    for start in range(0, DURATION_MS, 10_000):
+        field_id, payload = POLLED[(start // 10_000) % len(POLLED)]
+        events.append((start, frame(CONTROLLER, HEATING, GET, field_id)))
+        events.append((start + 120, frame(HEATING, CONTROLLER, RET, field_id, payload(rng))))
+    for start in range(3_000, DURATION_MS, 60_000):
+        events.append((start, frame(HEATING, BROADCAST, INF, OUTSIDE_TEMPERATURE, temperature(rng.uniform(-10, 15)))))
+    for start in range(7_000, DURATION_MS, 30_000):
+        raw = int(rng.uniform(19, 23) * 64)
+        events.append((start, frame(ROOM_UNIT, BROADCAST, INF, ROOM_TEMPERATURE, [raw >> 8, raw & 0xFF, 0x00])))
+    for start in range(5_000, DURATION_MS, 5 * 60_000):
+        minute = start // 60_000
+        events.append((start, frame(HEATING, BROADCAST, INF, DATE_TIME, [0x00, 124, 10, 19, 6, 12, minute % 60, 0, 0x00])))
+    for start, command in ((95_000, ACK), (455_000, NACK), (1_215_000, ACK)):
+        events.append((start, frame(CONTROLLER, HEATING, SET, SETPOINT, temperature(21.5))))
+        events.append((start + 150, frame(HEATING, CONTROLLER, command, SETPOINT)))
+    return sorted(events, key=lambda event: event[0])
+
+
+def serialize(events):
+    """Lays the frames out on the line, returns (time of the byte in ms, byte on the line) with overlapping bytes merged."""
+    line = {}
+    for start, data in events:
+        slot = int(start / BYTE_MS)
+        for offset, byte in enumerate(data):
+            # the line is inverted and pulled low by any sender, overlapping bytes are AND-ed
+            raw = byte ^ 0xFF
+            line[slot + offset] = line.get(slot + offset, 0xFF) & raw
+    return [(slot * BYTE_MS, line[slot]) for slot in sorted(line)]
+
+
+def capture(line):
+    """Splits the bytes into the records of the UART reads."""
+    output = bytearray(b"BSBC\x01")
+    pending = []
+    next_read = LOOP_MS
+    for timestamp, raw in line + [(float("inf"), None)]:
+        while pending and timestamp >= next_read:
+            chunk = pending[:CHUNK]
+            del pending[:CHUNK]
+            output += struct.pack(">IB", int(next_read), len(chunk)) + bytes(chunk)
+            next_read += LOOP_MS
+        if raw is None:
+            break
+        if not pending:
+            next_read = max(next_read, (int(timestamp) // LOOP_MS + 1) * LOOP_MS)
+        pending.append(raw)
+    return bytes(output)
+
+
+def noisy(events, rng):
+    result = []
+    for start, data in events:
+        data = list(data)
+        if rng.random() < 0.05:
+            position = rng.randrange(len(data))
+            data[position] ^= 1 << rng.randrange(8)
+        result.append((start, data))
+        # short bursts of noise in the gaps
+        if rng.random() < 0.2:
+            result.append((start + 60, [rng.randrange(256) for _ in range(rng.randint(1, 4))]))
+    return result
+
+
+def truncated(events, rng):
+    result = []
+    for start, data in events:
+        if rng.random() < 0.1:
+            data = data[: rng.randint(2, len(data) - 1)]
+        result.append((start, data))
+    return result
+
+
+def collided(events, rng):
+    result = list(events)
+    for start, data in events:
+        if rng.random() < 0.1:
+            offset = rng.randint(0, len(data) - 1) * BYTE_MS
+            result.append((start + offset, frame(OTHER, HEATING, GET, 0x053D0064)))
+    return sorted(result, key=lambda event: event[0])
+
+
+def main():
+    directory = os.path.dirname(os.path.abspath(__file__))
+    variants = {
+        "clean": lambda events, rng: events,
+        "noisy": noisy,
+        "truncated": truncated,
+        "collided": collided,
+    }
+    for name, variant in variants.items():
+        rng = random.Random(name)
+        events = variant(traffic(rng), rng)
+        with open(os.path.join(directory, name + ".bsbc"), "wb") as file:
+            file.write(capture(serialize(events)))
+        print(f"{name}: {len(events)} transmissions")
+
+
+if __name__ == "__main__":
+    main()
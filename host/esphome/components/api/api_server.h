@@ -0,0 +1,18 @@
+#pragma once
+
+// Host shim of the ESPHome API server, the harness decides whether a client is connected.
+
+namespace esphome {
+  namespace api {
+    class APIServer {
+    public:
+      bool is_connected() const { return connected_; }
+      void set_connected( const bool connected ) { connected_ = connected; }
+
+    private:
+      bool connected_ = true;
+    };
+
+    extern APIServer* global_api_server;
+  }
+}
@@ -0,0 +1,26 @@
+#pragma once
+
+#include <functional>
+
+#include "esphome/core/helpers.h"
+
+// Host shim of the ESPHome binary sensor.
+
+namespace esphome {
+  namespace binary_sensor {
+    class BinarySensor {
+    public:
+      void publish_state( const bool value ) {
+        state = value;
+        callback_.call( value );
+      }
+      void publish_initial_state( const bool value ) { publish_state( value ); }
+      void add_on_state_callback( std::function< void( bool ) >&& callback ) { callback_.add( std::move( callback ) ); }
+
+      bool state = false;
+
+    private:
+      CallbackManager< void( bool ) > callback_;
+    };
+  }
+}
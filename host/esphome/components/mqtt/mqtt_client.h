@@ -0,0 +1,18 @@
+#pragma once
+
+// Host shim of the ESPHome MQTT client, the harness decides whether the broker is connected.
+
+namespace esphome {
+  namespace mqtt {
+    class MQTTClientComponent {
+    public:
+      bool is_connected() const { return connected_; }
+      void set_connected( const bool connected ) { connected_ = connected; }
+
+    private:
+      bool connected_ = false;
+    };
+
+    extern MQTTClientComponent* global_mqtt_client;
+  }
+}
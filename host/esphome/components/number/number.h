@@ -0,0 +1,32 @@
+#pragma once
+
+#include <functional>
+
+#include "esphome/core/helpers.h"
+
+// Host shim of the ESPHome number, make_call() stands in for the frontend.
+
+namespace esphome {
+  namespace number {
+    class Number {
+    public:
+      virtual ~Number() = default;
+
+      void publish_state( const float value ) {
+        state = value;
+        callback_.call( value );
+      }
+      void add_on_state_callback( std::function< void( float ) >&& callback ) { callback_.add( std::move( callback ) ); }
+
+      void make_call( const float value ) { control( value ); }
+
+      float state = 0;
+
+    protected:
+      virtual void control( float value ) = 0;
+
+    private:
+      CallbackManager< void( float ) > callback_;
+    };
+  }
+}
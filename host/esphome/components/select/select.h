@@ -0,0 +1,33 @@
+#pragma once
+
+#include <functional>
+#include <string>
+
+#include "esphome/core/helpers.h"
+
+// Host shim of the ESPHome select.
+
+namespace esphome {
+  namespace select {
+    class Select {
+    public:
+      virtual ~Select() = default;
+
+      void publish_state( const std::string& value ) {
+        state = value;
+        callback_.call( state );
+      }
+      void add_on_state_callback( std::function< void( std::string ) >&& callback ) { callback_.add( std::move( callback ) ); }
+
+      void make_call( const std::string& value ) { control( value ); }
+
+      std::string state;
+
+    protected:
+      virtual void control( const std::string& value ) = 0;
+
+    private:
+      CallbackManager< void( std::string ) > callback_;
+    };
+  }
+}
@@ -0,0 +1,31 @@
+#pragma once
+
+#include <functional>
+#include <string>
+
+#include "esphome/core/helpers.h"
+
+// Host shim of the ESPHome sensor, the harness follows the published values with add_on_state_callback().
+
+namespace esphome {
+  namespace sensor {
+    class Sensor {
+    public:
+      void publish_state( const float value ) {
+        state      = value;
+        has_state_ = true;
+        callback_.call( value );
+      }
+      void add_on_state_callback( std::function< void( float ) >&& callback ) { callback_.add( std::move( callback ) ); }
+
+      float      get_state() const { return state; }
+      const bool has_state() const { return has_state_; }
+
+      float state = 0;
+
+    private:
+      bool                            has_state_ = false;
+      CallbackManager< void( float ) > callback_;
+    };
+  }
+}
@@ -0,0 +1,33 @@
+#pragma once
+
+#include <functional>
+
+#include "esphome/core/helpers.h"
+
+// Host shim of the ESPHome switch.
+
+namespace esphome {
+  namespace switch_ {
+    class Switch {
+    public:
+      virtual ~Switch() = default;
+
+      void publish_state( const bool value ) {
+        state = value;
+        callback_.call( value );
+      }
+      void add_on_state_callback( std::function< void( bool ) >&& callback ) { callback_.add( std::move( callback ) ); }
+
+      void turn_on() { write_state( true ); }
+      void turn_off() { write_state( false ); }
+
+      bool state = false;
+
+    protected:
+      virtual void write_state( bool state ) = 0;
+
+    private:
+      CallbackManager< void( bool ) > callback_;
+    };
+  }
+}
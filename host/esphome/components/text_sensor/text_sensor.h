@@ -0,0 +1,26 @@
+#pragma once
+
+#include <functional>
+#include <string>
+
+#include "esphome/core/helpers.h"
+
+// Host shim of the ESPHome text sensor.
+
+namespace esphome {
+  namespace text_sensor {
+    class TextSensor {
+    public:
+      void publish_state( const std::string& value ) {
+        state = value;
+        callback_.call( state );
+      }
+      void add_on_state_callback( std::function< void( std::string ) >&& callback ) { callback_.add( std::move( callback ) ); }
+
+      std::string state;
+
+    private:
+      CallbackManager< void( std::string ) > callback_;
+    };
+  }
+}
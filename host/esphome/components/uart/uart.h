@@ -0,0 +1,98 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+// Host shim of the ESPHome UART. The bytes are kept in fixed rings, so the shim itself never allocates in the
+// telegram path: the harness writes the received bytes with inject() and takes the sent ones with take().
+
+namespace esphome {
+  namespace uart {
+    class UARTComponent {
+    public:
+      // bytes as they arrive from the bus, returns false if the ring is full
+      bool inject( const uint8_t* data, const size_t length ) {
+        if( rx_.free() < length ) {
+          return false;
+        }
+        for( size_t i = 0; i < length; ++i ) {
+          rx_.push( data[i] );
+        }
+        return true;
+      }
+
+      // the bytes sent since the last call, returns their number
+      size_t take( uint8_t* data, const size_t size ) {
+        size_t length = 0;
+        while( length < size && !tx_.empty() ) {
+          data[length++] = tx_.pop();
+        }
+        return length;
+      }
+
+      size_t available() const { return rx_.size(); }
+
+      bool read_array( uint8_t* data, const size_t length ) {
+        if( rx_.size() < length ) {
+          return false;
+        }
+        for( size_t i = 0; i < length; ++i ) {
+          data[i] = rx_.pop();
+        }
+        return true;
+      }
+
+      void write_array( const uint8_t* data, const size_t length ) {
+        for( size_t i = 0; i < length && tx_.free() != 0; ++i ) {
+          tx_.push( data[i] );
+        }
+      }
+
+      static constexpr size_t Size = 4096;
+
+    private:
+      class Ring {
+      public:
+        size_t     size() const { return size_; }
+        size_t     free() const { return Size - size_; }
+        const bool empty() const { return size_ == 0; }
+
+        void push( const uint8_t data ) {
+          buffer_[( head_ + size_++ ) % Size] = data;
+        }
+        uint8_t pop() {
+          const uint8_t data = buffer_[head_];
+          head_              = ( head_ + 1 ) % Size;
+          --size_;
+          return data;
+        }
+
+      private:
+        uint8_t buffer_[Size];
+        size_t  head_ = 0;
+        size_t  size_ = 0;
+      };
+
+      Ring rx_;
+      Ring tx_;
+    };
+
+    class UARTDevice {
+    public:
+      UARTDevice() = default;
+      UARTDevice( UARTComponent* parent ) : parent_( parent ) {}
+
+      void set_uart_parent( UARTComponent* parent ) { parent_ = parent; }
+
+      int  available() { return parent_->available(); }
+      bool read_array( uint8_t* data, const size_t length ) { return parent_->read_array( data, length ); }
+      void write_array( const uint8_t* data, const size_t length ) { parent_->write_array( data, length ); }
+      void write_array( const std::vector< uint8_t >& data ) { parent_->write_array( data.data(), data.size() ); }
+      void flush() {}
+
+    protected:
+      UARTComponent* parent_ = nullptr;
+    };
+  }
+}
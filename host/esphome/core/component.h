@@ -0,0 +1,52 @@
+#pragma once
+
+#include <cstdint>
+#include <functional>
+#include <string>
+#include <vector>
+
+// Host shim of the ESPHome component. The intervals and timeouts are run by run_scheduler(), which the harness calls
+// in place of the scheduler of the application.
+
+namespace esphome {
+  const uint32_t SCHEDULER_DONT_RUN = 4294967295UL;
+
+  namespace setup_priority {
+    const float DATA = 600.0f;
+  }
+
+  class Component {
+  public:
+    virtual ~Component() = default;
+
+    virtual void  setup() {}
+    virtual void  loop() {}
+    virtual void  dump_config() {}
+    virtual float get_setup_priority() const { return 0; }
+
+    // calls the due intervals and timeouts
+    void run_scheduler( const uint32_t now );
+    // ms until the next interval or timeout is due, UINT32_MAX without any
+    const uint32_t get_time_until_scheduled( const uint32_t now ) const;
+
+  protected:
+    void set_interval( const std::string& name, const uint32_t interval, std::function< void() >&& callback );
+    void set_timeout( const std::string& name, const uint32_t timeout, std::function< void() >&& callback );
+    bool cancel_interval( const std::string& name );
+    bool cancel_timeout( const std::string& name );
+
+  private:
+    struct Item {
+      std::string             name;
+      uint32_t                interval;
+      uint32_t                next;
+      bool                    repeat;
+      std::function< void() > callback;
+    };
+
+    void add_item( const std::string& name, const uint32_t interval, const bool repeat, std::function< void() >&& callback );
+    bool cancel( const std::string& name, const bool repeat );
+
+    std::vector< Item > items_;
+  };
+}
@@ -0,0 +1,18 @@
+#pragma once
+
+#include <cstdint>
+
+// Host shim of the ESPHome HAL. The clock is simulated: it only moves when the harness advances it, so days of
+// operation run in seconds and millis() wraps around like on the device, after 49.7 days.
+
+namespace esphome {
+  uint32_t millis();
+  uint32_t micros();
+
+  namespace host {
+    // the simulated time since the start, in us
+    const uint64_t get_time();
+    void           set_time( const uint64_t us );
+    inline void    advance_time( const uint64_t us ) { set_time( get_time() + us ); }
+  }
+}
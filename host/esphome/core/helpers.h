@@ -0,0 +1,42 @@
+#pragma once
+
+#include <functional>
+#include <utility>
+#include <vector>
+
+// Host shim of the ESPHome helpers used by the component.
+
+namespace esphome {
+  template< typename T >
+  class CallbackManager;
+
+  template< typename... Ts >
+  class CallbackManager< void( Ts... ) > {
+  public:
+    void add( std::function< void( Ts... ) >&& callback ) { callbacks_.push_back( std::move( callback ) ); }
+
+    void call( Ts... args ) {
+      for( auto& callback : callbacks_ ) {
+        callback( args... );
+      }
+    }
+
+    const size_t size() const { return callbacks_.size(); }
+
+  private:
+    std::vector< std::function< void( Ts... ) > > callbacks_;
+  };
+
+  template< typename T >
+  class Parented {
+  public:
+    Parented() {}
+    Parented( T* parent ) : parent_( parent ) {}
+
+    T*   get_parent() const { return parent_; }
+    void set_parent( T* parent ) { parent_ = parent; }
+
+  protected:
+    T* parent_ = nullptr;
+  };
+}
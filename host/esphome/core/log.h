@@ -0,0 +1,45 @@
+#pragma once
+
+#include <cstdio>
+
+// Host shim of the ESPHome logger, the messages up to the level set with host::set_log_level() go to stderr or the file
+// set with host::set_log_file(). All levels are compiled in, like with ESPHOME_LOG_LEVEL VERY_VERBOSE on the device.
+
+#define ESPHOME_LOG_LEVEL_NONE         0
+#define ESPHOME_LOG_LEVEL_ERROR        1
+#define ESPHOME_LOG_LEVEL_WARN         2
+#define ESPHOME_LOG_LEVEL_INFO         3
+#define ESPHOME_LOG_LEVEL_CONFIG       4
+#define ESPHOME_LOG_LEVEL_DEBUG        5
+#define ESPHOME_LOG_LEVEL_VERBOSE      6
+#define ESPHOME_LOG_LEVEL_VERY_VERBOSE 7
+#define ESPHOME_LOG_LEVEL              ESPHOME_LOG_LEVEL_VERY_VERBOSE
+
+namespace esphome {
+  namespace host {
+    enum LogLevel { LogLevelNone, LogLevelError, LogLevelWarn, LogLevelInfo, LogLevelConfig, LogLevelDebug, LogLevelVerbose };
+
+    void       set_log_level( const int level );
+    // nullptr for stderr
+    void       set_log_file( FILE* file );
+    const bool is_logged( const int level );
+    void       log( const int level, const char* tag, const char* format, ... );
+  }
+}
+
+// like on the device, the arguments aren't evaluated if the level isn't logged
+#define ESP_LOG_HOST( level, tag, ... )                      \
+  do {                                                       \
+    if( esphome::host::is_logged( level ) ) {                \
+      esphome::host::log( level, tag, __VA_ARGS__ );         \
+    }                                                        \
+  } while( false )
+
+#define ESP_LOGE( tag, ... )      ESP_LOG_HOST( esphome::host::LogLevelError, tag, __VA_ARGS__ )
+#define ESP_LOGW( tag, ... )      ESP_LOG_HOST( esphome::host::LogLevelWarn, tag, __VA_ARGS__ )
+#define ESP_LOGI( tag, ... )      ESP_LOG_HOST( esphome::host::LogLevelInfo, tag, __VA_ARGS__ )
+#define ESP_LOGCONFIG( tag, ... ) ESP_LOG_HOST( esphome::host::LogLevelConfig, tag, __VA_ARGS__ )
+#define ESP_LOGD( tag, ... )      ESP_LOG_HOST( esphome::host::LogLevelDebug, tag, __VA_ARGS__ )
+#define ESP_LOGV( tag, ... )      ESP_LOG_HOST( esphome::host::LogLevelVerbose, tag, __VA_ARGS__ )
+
+#define YESNO( b ) ( ( b ) ? "YES" : "NO" )
@@ -0,0 +1,50 @@
+#pragma once
+
+#include <cstdint>
+#include <cstring>
+#include <map>
+#include <vector>
+
+// Host shim of the ESPHome preferences, kept in memory, so a restart can be simulated with the same global_preferences.
+
+namespace esphome {
+  class ESPPreferenceObject {
+  public:
+    ESPPreferenceObject() = default;
+    ESPPreferenceObject( std::vector< uint8_t >* data ) : data_( data ) {}
+
+    template< typename T >
+    bool save( const T* src ) {
+      if( data_ == nullptr ) {
+        return false;
+      }
+      data_->assign( reinterpret_cast< const uint8_t* >( src ), reinterpret_cast< const uint8_t* >( src ) + sizeof( T ) );
+      return true;
+    }
+
+    template< typename T >
+    bool load( T* dest ) {
+      if( data_ == nullptr || data_->size() != sizeof( T ) ) {
+        return false;
+      }
+      memcpy( dest, data_->data(), sizeof( T ) );
+      return true;
+    }
+
+  private:
+    std::vector< uint8_t >* data_ = nullptr;
+  };
+
+  class ESPPreferences {
+  public:
+    template< typename T >
+    ESPPreferenceObject make_preference( const uint32_t type, [[maybe_unused]] const bool in_flash = false ) {
+      return ESPPreferenceObject( &store_[type] );
+    }
+
+  private:
+    std::map< uint32_t, std::vector< uint8_t > > store_;
+  };
+
+  extern ESPPreferences* global_preferences;
+}
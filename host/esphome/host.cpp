@@ -0,0 +1,115 @@
+#include <algorithm>
+#include <cstdarg>
+#include <cstdio>
+
+#include "esphome/components/api/api_server.h"
+#include "esphome/components/mqtt/mqtt_client.h"
+#include "esphome/core/component.h"
+#include "esphome/core/hal.h"
+#include "esphome/core/log.h"
+#include "esphome/core/preferences.h"
+
+// The state behind the host shims: the simulated clock, the log level, the scheduler of the components and the globals
+// of ESPHome.
+
+namespace esphome {
+  namespace {
+    uint64_t time_us   = 0;
+    int      log_level = host::LogLevelNone;
+    FILE*    log_file  = nullptr;
+
+    ESPPreferences preferences;
+  }
+
+  ESPPreferences* global_preferences = &preferences;
+
+  namespace api {
+    APIServer* global_api_server = nullptr;
+  }
+  namespace mqtt {
+    MQTTClientComponent* global_mqtt_client = nullptr;
+  }
+
+  uint32_t millis() { return uint32_t( time_us / 1000 ); }
+  uint32_t micros() { return uint32_t( time_us ); }
+
+  namespace host {
+    const uint64_t get_time() { return time_us; }
+    void           set_time( const uint64_t us ) { time_us = us; }
+
+    void       set_log_level( const int level ) { log_level = level; }
+    void       set_log_file( FILE* file ) { log_file = file; }
+    const bool is_logged( const int level ) { return level <= log_level; }
+
+    void log( const int level, const char* tag, const char* format, ... ) {
+      static const char* const letters = "NEWICDV";
+
+      FILE* file = log_file != nullptr ? log_file : stderr;
+      fprintf( file, "[%10.3f][%c][%s] ", time_us / 1e6, letters[level], tag );
+      va_list args;
+      va_start( args, format );
+      vfprintf( file, format, args );
+      va_end( args );
+      fputc( '\n', file );
+    }
+  }
+
+  void Component::run_scheduler( const uint32_t now ) {
+    // the callbacks can add items, so iterate by index
+    for( size_t i = 0; i < items_.size(); ) {
+      if( int32_t( now - items_[i].next ) < 0 ) {
+        ++i;
+        continue;
+      }
+
+      std::function< void() > callback = items_[i].callback;
+      if( items_[i].repeat ) {
+        items_[i].next += items_[i].interval;
+        // don't catch up if the harness jumped ahead
+        if( int32_t( now - items_[i].next ) >= 0 ) {
+          items_[i].next = now + items_[i].interval;
+        }
+        ++i;
+      } else {
+        items_.erase( items_.begin() + i );
+      }
+      callback();
+    }
+  }
+
+  const uint32_t Component::get_time_until_scheduled( const uint32_t now ) const {
+    uint32_t time = UINT32_MAX;
+    for( const Item& item : items_ ) {
+      time = std::min( time, uint32_t( std::max( int32_t( item.next - now ), 0 ) ) );
+    }
+    return time;
+  }
+
+  void Component::set_interval( const std::string& name, const uint32_t interval, std::function< void() >&& callback ) {
+    add_item( name, interval, true, std::move( callback ) );
+  }
+
+  void Component::set_timeout( const std::string& name, const uint32_t timeout, std::function< void() >&& callback ) {
+    add_item( name, timeout, false, std::move( callback ) );
+  }
+
+  bool Component::cancel_interval( const std::string& name ) { return cancel( name, true ); }
+  bool Component::cancel_timeout( const std::string& name ) { return cancel( name, false ); }
+
+  void Component::add_item( const std::string& name, const uint32_t interval, const bool repeat, std::function< void() >&& callback ) {
+    cancel( name, repeat );
+    if( interval != SCHEDULER_DONT_RUN ) {
+      items_.push_back( { name, interval, millis() + interval, repeat, std::move( callback ) } );
+    }
+  }
+
+  bool Component::cancel( const std::string& name, const bool repeat ) {
+    for( auto item = items_.begin(); item != items_.end(); ++item ) {
+      if( item->name == name && item->repeat == repeat ) {
+        items_.erase( item );
+        return true;
+      }
+    }
+    return false;
+  }
+}